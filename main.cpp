@@ -17,7 +17,6 @@ uint16_t layerColors[3] = {ST7735_GREEN, ST7735_CYAN, ST7735_ORANGE};
 
 // Memory
 int virtualValues[3][7] = {0};
-int peakValues[3][7] = {0};      // Store peak per layer
 int startPhysicalPos[7] = {0};
 bool layerLocked[7] = {true, true, true, true, true, true, true};
 
@@ -26,16 +25,129 @@ const int channelPins[NUM_CHANNELS] = {A4, A5, A0, A1, A2, A3, A6};
 const int MASTER_PIN = A7;
 const int UNLOCK_THRESHOLD = 30; 
 
+// Input filtering. Every block from the sampler averages OVERSAMPLE
+// conversions per input into an EMA kept with FILTER_FRAC fractional bits. The reported value then follows the
+// EMA through a per-channel Schmitt window: continuing in the same direction
+// needs 1 count, reversing needs HYSTERESIS counts, so pot noise stops
+// producing updates while slow moves keep full resolution.
+const uint8_t OVERSAMPLE = 4;
+const uint8_t FILTER_FRAC = 4;
+const uint8_t EMA_SHIFT = 2;     // alpha = 1/4
+const int HYSTERESIS = 3;
+const uint8_t MASTER_SLOT = NUM_CHANNELS;
+const uint8_t NUM_INPUTS = NUM_CHANNELS + 1;
+int32_t filterEma[NUM_CHANNELS + 1];
+int filterOut[NUM_CHANNELS + 1];
+int8_t filterDir[NUM_CHANNELS + 1];
+bool filterPrimed[NUM_CHANNELS + 1];
+
+// ADC sampler. Timer1 triggers one conversion every ADC_PERIOD_US; the ISR
+// stores it and points the mux at the next input, so every input is sampled
+// at a fixed 1 kHz whatever the rest of the sketch is doing. After
+// OVERSAMPLE rounds the sums are published as one block (250 per second).
+const unsigned int ADC_PERIOD_US = 125;
+uint8_t adcMux[NUM_INPUTS];
+uint16_t adcAccum[NUM_INPUTS]; // ISR only
+uint8_t adcInput = 0;
+uint8_t adcRound = 0;
+volatile uint16_t adcBlock[NUM_INPUTS];
+volatile uint8_t adcBlockSeq = 0;
+uint8_t adcSeenSeq = 0;
+
+// Cooperative tasks, each on its own clock. None of them blocks, so the
+// longest single step (one display element) bounds everyone's latency.
+const unsigned long LAYER_SCAN_US = 5000;
+const unsigned long DISPLAY_STEP_US = 4000;
+unsigned long lastLayerScanUs = 0;
+unsigned long lastDisplayStepUs = 0;
+uint8_t displayCursor = 0;
+
+// Host link. The sketch boots speaking ASCII "DATA,..." lines; a host that
+// sends "VMX,BIN" gets compact binary frames instead:
+//   full:  [0xA5][seq][0<<4 | layer][master + 7 channels, 10 bit LE packed][CRC-8]
+//   delta: [0xA5][seq][1<<4 | layer][mask][changed values, 10 bit LE packed][CRC-8]
+// Mask bit 0 is the master, bit i+1 channel i. Nothing is sent while the
+// faders rest, except a full snapshot every KEEPALIVE_MS (or on "VMX,FULL").
+// The host notices lost binary frames by their sequence numbers, so the
+// keepalive only covers a lost last frame (or ASCII line) and can be rare.
+const uint8_t FRAME_SYNC = 0xA5;
+const uint8_t FRAME_FULL = 0;
+const uint8_t FRAME_DELTA = 1;
+const unsigned long ASCII_FRAME_US = 10000;
+const unsigned long BINARY_FRAME_US = 2000;
+const unsigned long KEEPALIVE_MS = 10000;
+bool binaryMode = false;
+uint8_t frameSeq = 0;
+char hostCmd[16];
+uint8_t hostCmdLen = 0;
+unsigned long lastFrameUs = 0;
+
+int lastSent[NUM_CHANNELS + 1];
+int lastSentLayer = -1;
+bool forceFull = true;
+unsigned long lastFullMs = 0;
+
+// Level meters from the host, in binary mode only (the ack ends in METER):
+//   [0xA6][mask][level per set bit, 0..CH_BAR_MAX_H][CRC-8 of mask and levels]
+// Mask bit i is channel i. Only the CRC can be 0x80 or above, so any other
+// such byte (a sync, or the start of something else) ends the frame.
+// Levels jump up, fall one pixel per METER_DECAY_US and drop to nothing when
+// the host stops sending for METER_TIMEOUT_MS.
+const uint8_t METER_SYNC = 0xA6;
+const unsigned long METER_DECAY_US = 20000;
+const unsigned long METER_HOLD_MS = 1000;
+const unsigned long METER_TIMEOUT_MS = 2500;
+uint8_t meterFrame[1 + NUM_CHANNELS];
+uint8_t meterFrameLen = 0;
+uint8_t meterFrameWant = 0;      // 0: not in a meter frame
+uint8_t meterTarget[NUM_CHANNELS];
+uint8_t meterShown[NUM_CHANNELS];
+uint8_t meterHold[NUM_CHANNELS];
+unsigned long meterHoldMs[NUM_CHANNELS];
+unsigned long lastMeterMs = 0;
+unsigned long lastMeterDecayUs = 0;
+
 Adafruit_ST7735 tft = Adafruit_ST7735(TFT_CS, TFT_DC, TFT_RST);
 
 // UI Positioning
 const int CH_BAR_WIDTH = 12;
+const int METER_WIDTH = 3;       // in the gap right of each bar
 const int CH_BAR_MAX_H = 90;     // Slightly shorter to ensure clearance
 const int CH_Y_BOTTOM = 125;     
 const int MASTER_BAR_Y = 145;    
 const int MASTER_BAR_H = 12;
 const int SEPARATOR_Y = 32;      // The Gray Line position
 
+// What is currently on the glass, so each loop only touches rows that change.
+// -1 forces a full redraw of that element.
+int drawnBar[NUM_CHANNELS];
+uint16_t drawnColor[NUM_CHANNELS];
+int drawnMeter[NUM_CHANNELS];
+int drawnHold[NUM_CHANNELS];
+int drawnMasterWidth = -1;
+
+// Loop timing, reported every STATS_INTERVAL_MS once the host asks with
+// "VMX,STATS" (so an idle link stays quiet otherwise):
+//   ASCII:  STAT,min,avg,max  (microseconds)
+//   binary: [0xA5][seq][2<<4 | layer][min][avg][max] (uint16 LE each)[CRC-8]
+const uint8_t FRAME_STATS = 2;
+const unsigned long STATS_INTERVAL_MS = 1000;
+bool statsRequested = false;
+unsigned long loopMinUs = 0xFFFFFFFF;
+unsigned long loopMaxUs = 0;
+unsigned long loopSumUs = 0;
+unsigned long loopCount = 0;
+unsigned long lastStatsMs = 0;
+
+// The layer number, drawn over the old one. The bars pick up the new layer
+// colour as the display task reaches them.
+void drawLayerHeader() {
+  tft.setCursor(5, 15);
+  tft.setTextColor(layerColors[currentLayer], ST7735_BLACK);
+  tft.setTextSize(2);
+  tft.print(currentLayer + 1);
+}
+
 void drawUIFrame() {
   tft.fillScreen(ST7735_BLACK);
   
@@ -44,11 +156,7 @@ void drawUIFrame() {
   tft.setTextColor(ST7735_WHITE);
   tft.setTextSize(1);
   tft.print("LAYER");
-  
-  tft.setCursor(5, 15);
-  tft.setTextColor(layerColors[currentLayer]);
-  tft.setTextSize(2);
-  tft.print(currentLayer + 1);
+  drawLayerHeader();
 
   tft.setCursor(85, 134);
   tft.setTextColor(ST7735_PINK);
@@ -57,43 +165,353 @@ void drawUIFrame() {
 
   // Draw the separator line once
   tft.drawFastHLine(0, SEPARATOR_Y, 128, ST7735_GRAY); 
+  tft.drawRect(4, MASTER_BAR_Y, 120, MASTER_BAR_H, ST7735_GRAY);
+
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    drawnBar[i] = -1;
+    drawnMeter[i] = -1;
+    drawnHold[i] = 0;
+  }
+  drawnMasterWidth = -1;
 }
 
-void setup() {
-  Serial.begin(115200);
-  pinMode(TFT_LED, OUTPUT);
-  digitalWrite(TFT_LED, HIGH);
+ISR(ADC_vect) {
+  uint16_t value = ADC;
+  TIFR1 = _BV(OCF1B); // the trigger is the flag's rising edge; re-arm it
+  uint8_t input = adcInput;
+  adcAccum[input] += value;
+  if (++input == NUM_INPUTS) {
+    input = 0;
+    if (++adcRound == OVERSAMPLE) {
+      for (uint8_t i = 0; i < NUM_INPUTS; i++) {
+        adcBlock[i] = adcAccum[i];
+        adcAccum[i] = 0;
+      }
+      adcRound = 0;
+      adcBlockSeq++;
+    }
+  }
+  adcInput = input;
+  // Takes effect for the next trigger, leaving the mux time to settle.
+  ADMUX = _BV(REFS0) | adcMux[input];
+}
 
-  for(int i = 0; i < 3; i++) pinMode(layerPins[i], INPUT_PULLUP);
+void startSampler() {
+  for (uint8_t i = 0; i < NUM_INPUTS; i++) {
+    adcMux[i] = (i == MASTER_SLOT ? MASTER_PIN : channelPins[i]) - A0;
+  }
+  DIDR0 = 0x3F; // no digital input buffers on A0-A5 (A6/A7 have none)
+  ADMUX = _BV(REFS0) | adcMux[0];
+  ADCSRB = _BV(ADTS2) | _BV(ADTS0); // auto trigger: Timer1 compare match B
+  ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0); // 125 kHz, 104 us
 
-  tft.initR(INITR_BLACKTAB); 
-  tft.setRotation(2); 
-  drawUIFrame();
+  // Timer1 in CTC mode at 2 MHz, matching B at the top of every period.
+  TCCR1A = 0;
+  TCCR1B = _BV(WGM12) | _BV(CS11);
+  OCR1A = ADC_PERIOD_US * 2 - 1;
+  OCR1B = OCR1A;
+  TCNT1 = 0;
+  TIMSK1 = 0;
+}
+
+// Copies out the newest block, if there is one the sketch has not seen yet.
+bool takeAdcBlock(uint16_t* sums) {
+  if (adcBlockSeq == adcSeenSeq) return false;
+  noInterrupts();
+  for (uint8_t i = 0; i < NUM_INPUTS; i++) sums[i] = adcBlock[i];
+  adcSeenSeq = adcBlockSeq;
+  interrupts();
+  return true;
+}
+
+int filterInput(uint8_t slot, uint16_t sum) {
+  int32_t sample = ((int32_t)sum << FILTER_FRAC) / OVERSAMPLE;
+
+  if (!filterPrimed[slot]) {
+    filterEma[slot] = sample;
+    filterOut[slot] = (sample + (1 << (FILTER_FRAC - 1))) >> FILTER_FRAC;
+    filterDir[slot] = 0;
+    filterPrimed[slot] = true;
+    return filterOut[slot];
+  }
+  filterEma[slot] += (sample - filterEma[slot]) >> EMA_SHIFT;
+
+  int target = (filterEma[slot] + (1 << (FILTER_FRAC - 1))) >> FILTER_FRAC;
+  target = constrain(target, 0, 1023);
+  int diff = target - filterOut[slot];
+  if (diff == 0) return filterOut[slot];
 
-  for(int i=0; i<NUM_CHANNELS; i++) {
-    startPhysicalPos[i] = analogRead(channelPins[i]);
+  int8_t dir = diff > 0 ? 1 : -1;
+  int window = (dir == filterDir[slot]) ? 1 : HYSTERESIS;
+  // Always let the ends of travel through so 0% and 100% are reachable.
+  if (abs(diff) >= window || target == 0 || target == 1023) {
+    filterOut[slot] = target;
+    filterDir[slot] = dir;
   }
+  return filterOut[slot];
 }
 
-void loop() {
-  // 1. Layer Switching
-  int oldLayer = currentLayer;
-  for (int i = 0; i < 3; i++) {
-    if (digitalRead(layerPins[i]) == LOW) currentLayer = i;
+bool drawChannel(int i, int barHeight, uint16_t color) {
+  if (barHeight == drawnBar[i] && color == drawnColor[i]) return false;
+
+  int xPos = 6 + (i * 17);
+  if (drawnBar[i] < 0 || color != drawnColor[i]) {
+    // We start erasing 1 pixel BELOW the separator to keep the line clean
+    int eraseStart = SEPARATOR_Y + 1;
+    tft.fillRect(xPos, eraseStart, CH_BAR_WIDTH, (CH_Y_BOTTOM - barHeight) - eraseStart + 2, ST7735_BLACK);
+    tft.fillRect(xPos, CH_Y_BOTTOM - barHeight, CH_BAR_WIDTH, barHeight, color);
+  } else if (barHeight > drawnBar[i]) {
+    tft.fillRect(xPos, CH_Y_BOTTOM - barHeight, CH_BAR_WIDTH, barHeight - drawnBar[i], color);
+  } else if (barHeight < drawnBar[i]) {
+    tft.fillRect(xPos, CH_Y_BOTTOM - drawnBar[i], CH_BAR_WIDTH, drawnBar[i] - barHeight, ST7735_BLACK);
+  }
+
+  drawnBar[i] = barHeight;
+  drawnColor[i] = color;
+  return true;
+}
+
+// The level strip beside a channel, with a red peak-hold tick on top.
+bool drawMeter(int i, int level, int hold) {
+  if (level == drawnMeter[i] && hold == drawnHold[i]) return false;
+
+  int xPos = 6 + (i * 17) + CH_BAR_WIDTH + 1;
+  if (drawnMeter[i] < 0) {
+    tft.fillRect(xPos, CH_Y_BOTTOM - CH_BAR_MAX_H, METER_WIDTH, CH_BAR_MAX_H - level, ST7735_BLACK);
+    tft.fillRect(xPos, CH_Y_BOTTOM - level, METER_WIDTH, level, ST7735_WHITE);
+  } else if (level > drawnMeter[i]) {
+    tft.fillRect(xPos, CH_Y_BOTTOM - level, METER_WIDTH, level - drawnMeter[i], ST7735_WHITE);
+  } else if (level < drawnMeter[i]) {
+    tft.fillRect(xPos, CH_Y_BOTTOM - drawnMeter[i], METER_WIDTH, drawnMeter[i] - level, ST7735_BLACK);
+  }
+
+  // Restore the row under the old tick; the fills above may have covered the
+  // new one, so it is always drawn last.
+  if (drawnHold[i] > 0 && drawnHold[i] != hold) {
+    int y = CH_Y_BOTTOM - drawnHold[i];
+    tft.drawFastHLine(xPos, y, METER_WIDTH, drawnHold[i] <= level ? ST7735_WHITE : ST7735_BLACK);
+  }
+  if (hold > 0) tft.drawFastHLine(xPos, CH_Y_BOTTOM - hold, METER_WIDTH, ST7735_RED);
+
+  drawnMeter[i] = level;
+  drawnHold[i] = hold;
+  return true;
+}
+
+bool drawMaster(int masterWidth) {
+  if (masterWidth == drawnMasterWidth) return false;
+  if (drawnMasterWidth < 0) {
+    tft.fillRect(5, MASTER_BAR_Y + 1, masterWidth, MASTER_BAR_H - 2, ST7735_PINK);
+    tft.fillRect(5 + masterWidth, MASTER_BAR_Y + 1, 118 - masterWidth, MASTER_BAR_H - 2, ST7735_BLACK);
+  } else if (masterWidth > drawnMasterWidth) {
+    tft.fillRect(5 + drawnMasterWidth, MASTER_BAR_Y + 1, masterWidth - drawnMasterWidth, MASTER_BAR_H - 2, ST7735_PINK);
+  } else {
+    tft.fillRect(5 + masterWidth, MASTER_BAR_Y + 1, drawnMasterWidth - masterWidth, MASTER_BAR_H - 2, ST7735_BLACK);
+  }
+  drawnMasterWidth = masterWidth;
+  return true;
+}
+
+// CRC-8, polynomial 0x07, init 0x00
+uint8_t crc8(const uint8_t* data, uint8_t len) {
+  uint8_t crc = 0;
+  for (uint8_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t b = 0; b < 8; b++) crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+  }
+  return crc;
+}
+
+void handleHostCommand() {
+  if (strcmp(hostCmd, "VMX,BIN") == 0) {
+    // FILTERED: values are already denoised, the host needs no extra gate.
+    // METER: meter frames are welcome.
+    Serial.println("VMX,OK,BIN,FILTERED,METER");
+    binaryMode = true;
+    forceFull = true;
+  } else if (strcmp(hostCmd, "VMX,ASCII") == 0) {
+    binaryMode = false;
+    Serial.println("VMX,OK,ASCII");
+    forceFull = true;
+  } else if (strcmp(hostCmd, "VMX,FULL") == 0) {
+    forceFull = true;
+  } else if (strcmp(hostCmd, "VMX,STATS") == 0) {
+    statsRequested = true;
+  }
+}
+
+void applyMeters() {
+  uint8_t n = 1;
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    if (!(meterFrame[0] & (1 << i))) continue;
+    uint8_t level = meterFrame[n++];
+    meterTarget[i] = level > CH_BAR_MAX_H ? CH_BAR_MAX_H : level;
+  }
+  lastMeterMs = millis();
+}
+
+// Collects meter frames; false for bytes that are not part of one.
+bool takeMeterByte(uint8_t c) {
+  if (meterFrameWant > 0 && meterFrameLen == meterFrameWant) {
+    if (crc8(meterFrame, meterFrameLen) == c) applyMeters();
+    meterFrameWant = 0;
+    return true;
+  }
+  if (c == METER_SYNC) {
+    meterFrameLen = 0;
+    meterFrameWant = 1;
+    return true;
+  }
+  if (meterFrameWant == 0) return false;
+  if (c >= 0x80) {
+    meterFrameWant = 0;
+    return false;
+  }
+  meterFrame[meterFrameLen++] = c;
+  if (meterFrameLen == 1) {
+    for (uint8_t mask = c & 0x7F; mask; mask &= mask - 1) meterFrameWant++;
+  }
+  return true;
+}
+
+void pollHostCommands() {
+  while (Serial.available() > 0) {
+    uint8_t b = Serial.read();
+    if (takeMeterByte(b)) continue;
+    char c = b;
+    if (c == '\n' || c == '\r') {
+      hostCmd[hostCmdLen] = '\0';
+      if (hostCmdLen > 0) handleHostCommand();
+      hostCmdLen = 0;
+    } else if (hostCmdLen < sizeof(hostCmd) - 1) {
+      hostCmd[hostCmdLen++] = c;
+    }
+  }
+}
+
+void sendAscii(const int* values) {
+  // Format: DATA,Layer,Master,Ch0,Ch1,Ch2,Ch3,Ch4,Ch5,Ch6
+  Serial.print("DATA,");
+  Serial.print(currentLayer);
+  for (int i = 0; i <= NUM_CHANNELS; i++) {
+    Serial.print(",");
+    Serial.print(values[i]);
   }
+  Serial.println(); // Ends with \r\n for easy getline() in C++
+}
+
+void sendBinary(uint8_t type, uint8_t mask, const int* values) {
+  uint8_t frame[4 + 10 + 1];
+  uint8_t pos = 0;
+  frame[pos++] = FRAME_SYNC;
+  frame[pos++] = frameSeq++;
+  frame[pos++] = (type << 4) | (currentLayer & 0x0F);
+  if (type == FRAME_DELTA) frame[pos++] = mask;
 
-  if (currentLayer != oldLayer) {
-    for(int i = 0; i < NUM_CHANNELS; i++) {
-      layerLocked[i] = true;
-      startPhysicalPos[i] = analogRead(channelPins[i]);
+  // Pack the selected values as 10 bit fields, least significant bit first.
+  uint32_t bits = 0;
+  uint8_t nbits = 0;
+  for (int i = 0; i <= NUM_CHANNELS; i++) {
+    if (!(mask & (1 << i))) continue;
+    bits |= (uint32_t)(values[i] & 0x3FF) << nbits;
+    nbits += 10;
+    while (nbits >= 8) {
+      frame[pos++] = bits & 0xFF;
+      bits >>= 8;
+      nbits -= 8;
     }
-    drawUIFrame();
   }
+  if (nbits > 0) frame[pos++] = bits & 0xFF;
+  frame[pos] = crc8(frame + 1, pos - 1);
+  Serial.write(frame, pos + 1);
+}
+
+// Returns true if a frame went out.
+bool reportChanges() {
+  int values[NUM_CHANNELS + 1];
+  values[0] = filterOut[MASTER_SLOT];
+  for (int i = 0; i < NUM_CHANNELS; i++) values[i + 1] = virtualValues[currentLayer][i];
 
-  // 2. Vertical Channels
+  uint8_t mask = 0;
+  for (int i = 0; i <= NUM_CHANNELS; i++) {
+    if (values[i] != lastSent[i]) mask |= 1 << i;
+  }
+
+  bool full = forceFull || currentLayer != lastSentLayer || millis() - lastFullMs >= KEEPALIVE_MS;
+  if (!full && mask == 0) return false;
+  if (full) {
+    mask = 0xFF;
+    forceFull = false;
+    lastSentLayer = currentLayer;
+    lastFullMs = millis();
+  }
+  for (int i = 0; i <= NUM_CHANNELS; i++) {
+    if (mask & (1 << i)) lastSent[i] = values[i];
+  }
+
+  // ASCII hosts always get the whole state, just less often.
+  if (!binaryMode) sendAscii(values);
+  else sendBinary(full ? FRAME_FULL : FRAME_DELTA, mask, values);
+  return true;
+}
+
+void sendLoopStats(unsigned long avgUs) {
+  if (!binaryMode) {
+    Serial.print("STAT,");
+    Serial.print(loopMinUs);
+    Serial.print(",");
+    Serial.print(avgUs);
+    Serial.print(",");
+    Serial.println(loopMaxUs);
+    return;
+  }
+  uint8_t frame[10];
+  unsigned long stats[3] = {loopMinUs, avgUs, loopMaxUs};
+  frame[0] = FRAME_SYNC;
+  frame[1] = frameSeq++;
+  frame[2] = (FRAME_STATS << 4) | (currentLayer & 0x0F);
+  for (int i = 0; i < 3; i++) {
+    uint16_t v = stats[i] > 0xFFFF ? 0xFFFF : stats[i];
+    frame[3 + i * 2] = v & 0xFF;
+    frame[4 + i * 2] = v >> 8;
+  }
+  frame[9] = crc8(frame + 1, 8);
+  Serial.write(frame, sizeof(frame));
+}
+
+void recordLoopTime(unsigned long us) {
+  if (us < loopMinUs) loopMinUs = us;
+  if (us > loopMaxUs) loopMaxUs = us;
+  loopSumUs += us;
+  loopCount++;
+
+  // The window restarts on schedule even when nobody asked, so the sums
+  // never overflow.
+  if (millis() - lastStatsMs < STATS_INTERVAL_MS) return;
+  lastStatsMs = millis();
+  if (statsRequested) sendLoopStats(loopSumUs / loopCount);
+
+  loopMinUs = 0xFFFFFFFF;
+  loopMaxUs = 0;
+  loopSumUs = 0;
+  loopCount = 0;
+}
+
+// --- TASKS ---
+
+// True once per period; a task that fell behind runs once, not in a burst.
+bool due(unsigned long& lastUs, unsigned long periodUs) {
+  unsigned long now = micros();
+  if (now - lastUs < periodUs) return false;
+  lastUs = (now - lastUs < 2 * periodUs) ? lastUs + periodUs : now;
+  return true;
+}
+
+// Runs for every block from the sampler.
+void processInputs(const uint16_t* sums) {
   for (int i = 0; i < NUM_CHANNELS; i++) {
-    int physicalPos = analogRead(channelPins[i]);
-    
+    int physicalPos = filterInput(i, sums[i]);
+
     if (layerLocked[i]) {
       if (abs(physicalPos - startPhysicalPos[i]) > UNLOCK_THRESHOLD) {
         layerLocked[i] = false;
@@ -103,48 +521,110 @@ void loop() {
     if (!layerLocked[i]) {
       virtualValues[currentLayer][i] = physicalPos;
     }
+  }
+  filterInput(MASTER_SLOT, sums[MASTER_SLOT]);
+}
 
-    // Update Peak
-    if (virtualValues[currentLayer][i] > peakValues[currentLayer][i]) {
-      peakValues[currentLayer][i] = virtualValues[currentLayer][i];
-    }
+void scanLayerButtons() {
+  int oldLayer = currentLayer;
+  for (int i = 0; i < 3; i++) {
+    if (digitalRead(layerPins[i]) == LOW) currentLayer = i;
+  }
+  if (currentLayer == oldLayer) return;
 
-    int xPos = 6 + (i * 17);
-    int barHeight = map(virtualValues[currentLayer][i], 0, 1023, 0, CH_BAR_MAX_H);
-    int peakHeight = map(peakValues[currentLayer][i], 0, 1023, 0, CH_BAR_MAX_H);
-    
-    uint16_t color = layerLocked[i] ? ST7735_GRAY : layerColors[currentLayer];
-    
-    // Draw Bar
-    tft.fillRect(xPos, CH_Y_BOTTOM - barHeight, CH_BAR_WIDTH, barHeight, color);
-    
-    // Erase space between Bar Top and Peak (or Separator)
-    // We start erasing 1 pixel BELOW the separator to keep the line clean
-    int eraseStart = SEPARATOR_Y + 1;
-    int eraseHeight = (CH_Y_BOTTOM - barHeight) - eraseStart;
-    tft.fillRect(xPos, eraseStart, CH_BAR_WIDTH, eraseHeight, ST7735_BLACK);
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    layerLocked[i] = true;
+    startPhysicalPos[i] = filterOut[i];
+  }
+  drawLayerHeader();
+}
 
-    // Draw Red Peak Line (2 pixels high)
-    tft.drawFastHLine(xPos, CH_Y_BOTTOM - peakHeight, CH_BAR_WIDTH, ST7735_RED);
-    tft.drawFastHLine(xPos, CH_Y_BOTTOM - peakHeight + 1, CH_BAR_WIDTH, ST7735_RED);
+// Fast attack, slow fall; the tick holds the highest level for METER_HOLD_MS
+// and then falls with it.
+void meterStep() {
+  unsigned long nowMs = millis();
+  if (nowMs - lastMeterMs > METER_TIMEOUT_MS) memset(meterTarget, 0, sizeof(meterTarget));
+  for (int i = 0; i < NUM_CHANNELS; i++) {
+    if (meterTarget[i] > meterShown[i]) meterShown[i] = meterTarget[i];
+    else if (meterShown[i] > meterTarget[i]) meterShown[i]--;
+    if (meterShown[i] >= meterHold[i]) {
+      meterHold[i] = meterShown[i];
+      meterHoldMs[i] = nowMs;
+    } else if (nowMs - meterHoldMs[i] > METER_HOLD_MS) {
+      meterHold[i]--;
+    }
   }
+}
 
-  // 3. Horizontal Master
-  int masterVal = analogRead(MASTER_PIN);
-  int masterWidth = map(masterVal, 0, 1023, 0, 118);
-  tft.drawRect(4, MASTER_BAR_Y, 120, MASTER_BAR_H, ST7735_GRAY);
-  tft.fillRect(5, MASTER_BAR_Y + 1, masterWidth, MASTER_BAR_H - 2, ST7735_PINK);
-  tft.fillRect(5 + masterWidth, MASTER_BAR_Y + 1, 118 - masterWidth, MASTER_BAR_H - 2, ST7735_BLACK);
-  // 4. --- SERIAL PRINTER FOR LINUX HOST ---
-  // Format: DATA,Layer,Master,Ch0,Ch1,Ch2,Ch3,Ch4,Ch5,Ch6
-  Serial.print("DATA,");
-  Serial.print(currentLayer);
-  Serial.print(",");
-  Serial.print(masterVal);
-  for(int i = 0; i < NUM_CHANNELS; i++) {
-    Serial.print(",");
-    Serial.print(virtualValues[currentLayer][i]);
+// Brings at most one element (a channel column or the master bar) up to date
+// per step, so a screen full of changes never stalls the serial link.
+void displayStep() {
+  for (uint8_t n = 0; n < NUM_INPUTS; n++) {
+    uint8_t i = displayCursor;
+    displayCursor = (displayCursor + 1) % NUM_INPUTS;
+    bool drew;
+    if (i == MASTER_SLOT) {
+      drew = drawMaster(map(filterOut[MASTER_SLOT], 0, 1023, 0, 118));
+    } else {
+      int barHeight = map(virtualValues[currentLayer][i], 0, 1023, 0, CH_BAR_MAX_H);
+      uint16_t color = layerLocked[i] ? ST7735_GRAY : layerColors[currentLayer];
+      drew = drawChannel(i, barHeight, color);
+      drew |= drawMeter(i, meterShown[i], meterHold[i]);
+    }
+    if (drew) return;
   }
-  Serial.println(); // Ends with \r\n for easy getline() in C++
-  delay(10);
-}
\ No newline at end of file
+}
+
+// Changes go out as soon as they are known, at most one frame per interval.
+void serialStep() {
+  pollHostCommands();
+  unsigned long interval = binaryMode ? BINARY_FRAME_US : ASCII_FRAME_US;
+  if (micros() - lastFrameUs < interval) return;
+  if (reportChanges()) lastFrameUs = micros();
+}
+
+void setup() {
+  Serial.begin(115200);
+  pinMode(TFT_LED, OUTPUT);
+  digitalWrite(TFT_LED, HIGH);
+
+  for(int i = 0; i < 3; i++) pinMode(layerPins[i], INPUT_PULLUP);
+
+  tft.initR(INITR_BLACKTAB); 
+  tft.setRotation(2); 
+  drawUIFrame();
+
+  startSampler();
+  uint16_t sums[NUM_INPUTS];
+  while (!takeAdcBlock(sums)) {}
+  for (uint8_t i = 0; i < NUM_INPUTS; i++) filterInput(i, sums[i]);
+  for (int i = 0; i < NUM_CHANNELS; i++) startPhysicalPos[i] = filterOut[i];
+}
+
+// Loop timing covers the passes that did any work, i.e. how long one step of
+// the slowest task can hold up the others.
+void loop() {
+  unsigned long stepStartUs = micros();
+  bool worked = false;
+
+  uint16_t sums[NUM_INPUTS];
+  if (takeAdcBlock(sums)) {
+    processInputs(sums);
+    worked = true;
+  }
+  if (due(lastLayerScanUs, LAYER_SCAN_US)) {
+    scanLayerButtons();
+    worked = true;
+  }
+  serialStep();
+  if (due(lastMeterDecayUs, METER_DECAY_US)) {
+    meterStep();
+    worked = true;
+  }
+  if (due(lastDisplayStepUs, DISPLAY_STEP_US)) {
+    displayStep();
+    worked = true;
+  }
+
+  if (worked) recordLoopTime(micros() - stepStartUs);
+}
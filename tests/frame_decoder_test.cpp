@@ -0,0 +1,251 @@
+// FrameDecoder against hand-built streams: chunking, corruption, resync,
+// delta merging and sequence tracking. Build and run from the repo root:
+//   g++ -std=c++17 -O2 -Wall -Wextra -I. tests/frame_decoder_test.cpp -o frame_decoder_test && ./frame_decoder_test
+#include "volmix_frame.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond)                                                                     \
+    do {                                                                                \
+        if (!(cond)) {                                                                  \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed\n"; \
+            failures++;                                                                 \
+        }                                                                               \
+    } while (0)
+
+// Master + 7 channels, as the decoder hands them out.
+using Values = std::vector<int>;
+
+static Values valuesOf(const Frame& frame) {
+    Values v{frame.master};
+    for (int i = 0; i < NUM_FADERS; i++) v.push_back(frame.channels[i]);
+    return v;
+}
+
+// The values selected by mask, 10 bit LE packed, as the firmware sends them.
+static std::string pack(const Values& values, uint8_t mask) {
+    std::string out;
+    uint32_t bits = 0;
+    int nbits = 0;
+    for (int i = 0; i <= NUM_FADERS; i++) {
+        if (!(mask & (1 << i))) continue;
+        bits |= static_cast<uint32_t>(values[i] & 0x3FF) << nbits;
+        nbits += 10;
+        while (nbits >= 8) {
+            out += static_cast<char>(bits & 0xFF);
+            bits >>= 8;
+            nbits -= 8;
+        }
+    }
+    if (nbits > 0) out += static_cast<char>(bits & 0xFF);
+    return out;
+}
+
+static std::string seal(std::string frame) {
+    frame += static_cast<char>(crc8(reinterpret_cast<const uint8_t*>(frame.data()) + 1, frame.size() - 1));
+    return frame;
+}
+
+static std::string fullFrame(uint8_t seq, int layer, const Values& values) {
+    std::string f{static_cast<char>(FRAME_SYNC), static_cast<char>(seq), static_cast<char>(FRAME_FULL << 4 | layer)};
+    return seal(f + pack(values, ALL_FIELDS));
+}
+
+static std::string deltaFrame(uint8_t seq, int layer, uint8_t mask, const Values& values) {
+    std::string f{static_cast<char>(FRAME_SYNC), static_cast<char>(seq), static_cast<char>(FRAME_DELTA << 4 | layer),
+                  static_cast<char>(mask)};
+    return seal(f + pack(values, mask));
+}
+
+static std::string dataLine(int layer, const Values& values) {
+    std::string line = "DATA," + std::to_string(layer);
+    for (int v : values) line += "," + std::to_string(v);
+    return line + "\n";
+}
+
+// Feeds the chunks in order and collects every frame.
+static std::vector<Frame> decode(FrameDecoder& decoder, const std::vector<std::string>& chunks) {
+    std::vector<Frame> frames;
+    for (auto const& chunk : chunks) {
+        decoder.feed(chunk.data(), chunk.size(), [&](const Frame& frame) { frames.push_back(frame); });
+    }
+    return frames;
+}
+
+static std::vector<Frame> decode(const std::string& stream) {
+    FrameDecoder decoder;
+    return decode(decoder, {stream});
+}
+
+const Values A{512, 1, 2, 3, 1000, 1023, 0, 700};
+const Values B{100, 900, 800, 700, 600, 500, 400, 300};
+
+// Any split into two reads, and one byte per read, yields the same frames.
+static void testEverySplit() {
+    struct Case {
+        const char* name;
+        std::string stream;
+        std::vector<Values> expected;
+    };
+    std::vector<Case> cases = {
+        {"ascii line", dataLine(1, A), {A}},
+        {"ascii line, CRLF", dataLine(1, A).insert(dataLine(1, A).size() - 1, "\r"), {A}},
+        {"full frame", fullFrame(7, 1, A), {A}},
+        {"full then delta", fullFrame(7, 1, A) + deltaFrame(8, 1, 0x05, B), {A, {B[0], A[1], B[2], A[3], A[4], A[5], A[6], A[7]}}},
+        {"line then frame", dataLine(0, B) + fullFrame(0, 2, A), {B, A}},
+    };
+    for (auto const& c : cases) {
+        for (size_t split = 0; split <= c.stream.size(); split++) {
+            FrameDecoder decoder;
+            auto frames = decode(decoder, {c.stream.substr(0, split), c.stream.substr(split)});
+            CHECK(frames.size() == c.expected.size());
+            for (size_t i = 0; i < frames.size() && i < c.expected.size(); i++) CHECK(valuesOf(frames[i]) == c.expected[i]);
+            CHECK(decoder.errorCount() == 0 && decoder.corruptCount() == 0);
+            if (frames.size() != c.expected.size()) std::cerr << "  case '" << c.name << "', split at " << split << "\n";
+        }
+        FrameDecoder decoder;
+        std::vector<std::string> bytes;
+        for (char ch : c.stream) bytes.emplace_back(1, ch);
+        auto frames = decode(decoder, bytes);
+        CHECK(frames.size() == c.expected.size());
+        if (!frames.empty()) CHECK(valuesOf(frames.back()) == c.expected.back());
+    }
+}
+
+// A frame failing its CRC is dropped, a full snapshot is asked for, and the
+// next good frame still comes through, even when the bad one holds a sync
+// byte that leads the decoder astray.
+static void testBadCrcResync() {
+    std::string bad = fullFrame(1, 0, A);
+    bad.back() ^= 0x55;
+    FrameDecoder decoder;
+    auto frames = decode(decoder, {bad + fullFrame(2, 0, B)});
+    CHECK(frames.size() == 1);
+    if (!frames.empty()) CHECK(valuesOf(frames[0]) == B);
+    CHECK(decoder.corruptCount() == 1);
+    CHECK(decoder.takeResyncRequest());
+    CHECK(!decoder.takeResyncRequest());
+
+    // 0xA5 packed into the payload: 0x1A5 as the master encodes to a 0xA5 byte.
+    Values syncy = A;
+    syncy[0] = 0x1A5;
+    std::string trap = fullFrame(3, 0, syncy);
+    CHECK(trap.find(static_cast<char>(FRAME_SYNC), 1) != std::string::npos);
+    trap.back() ^= 0x01;
+    for (size_t split = 0; split <= trap.size() + 14; split++) {
+        FrameDecoder d;
+        std::string stream = trap + fullFrame(4, 0, B) + fullFrame(5, 0, A);
+        auto got = decode(d, {stream.substr(0, split), stream.substr(split)});
+        CHECK(got.size() >= 1);
+        if (!got.empty()) CHECK(valuesOf(got.back()) == A);
+        CHECK(d.corruptCount() >= 1);
+    }
+
+    // Line noise in front of a frame is skipped.
+    frames = decode(std::string("\x01\x02garbage") + "\n" + fullFrame(9, 0, A));
+    CHECK(frames.size() == 1);
+}
+
+// 0xA5 in the middle of a line: the line is dropped and the stream recovers.
+static void testSyncByteInLine() {
+    // A binary frame cutting into a half-sent line.
+    FrameDecoder decoder;
+    std::string line = dataLine(0, B);
+    auto frames = decode(decoder, {line.substr(0, 9) + fullFrame(1, 0, A) + dataLine(2, B)});
+    CHECK(frames.size() == 2);
+    if (frames.size() == 2) {
+        CHECK(valuesOf(frames[0]) == A && frames[0].seq == 1);
+        CHECK(valuesOf(frames[1]) == B && frames[1].layer == 2 && frames[1].seq == -1);
+    }
+    CHECK(decoder.errorCount() == 1);
+
+    // A stray 0xA5 inside a line costs at most that line and the next.
+    FrameDecoder stray;
+    std::string noisy = dataLine(0, A);
+    noisy.insert(12, 1, static_cast<char>(FRAME_SYNC));
+    frames = decode(stray, {noisy + dataLine(1, B) + dataLine(2, A) + dataLine(3, B)});
+    CHECK(frames.size() >= 2);
+    if (frames.size() >= 2) {
+        CHECK(frames[frames.size() - 2].layer == 2 && valuesOf(frames[frames.size() - 2]) == A);
+        CHECK(frames.back().layer == 3 && valuesOf(frames.back()) == B);
+    }
+    CHECK(stray.errorCount() + stray.corruptCount() >= 1);
+}
+
+// Deltas carry only what moved; the rest comes from the last full frame.
+static void testDeltaMerge() {
+    FrameDecoder decoder;
+    auto frames = decode(decoder, {fullFrame(10, 1, A), deltaFrame(11, 1, 0x81, B), deltaFrame(12, 2, 0x10, A)});
+    CHECK(frames.size() == 3);
+    if (frames.size() != 3) return;
+    CHECK(frames[0].mask == ALL_FIELDS);
+    CHECK(frames[1].mask == 0x81);
+    Values merged = A;
+    merged[0] = B[0];
+    merged[7] = B[7];
+    CHECK(valuesOf(frames[1]) == merged);
+    merged[4] = A[4];
+    CHECK(valuesOf(frames[2]) == merged);
+    CHECK(frames[2].layer == 2 && frames[2].mask == 0x10);
+    CHECK(decoder.droppedCount() == 0 && !decoder.takeResyncRequest());
+
+    // An ASCII line replaces the whole state.
+    frames = decode(decoder, {dataLine(0, B), deltaFrame(13, 0, 0x02, A)});
+    CHECK(frames.size() == 2);
+    if (frames.size() == 2) {
+        Values v = B;
+        v[1] = A[1];
+        CHECK(valuesOf(frames[1]) == v);
+    }
+}
+
+// The 8-bit counter wraps without counting a gap; missing frames are counted
+// across the wrap, and a gap before a delta asks for a full snapshot.
+static void testSequence() {
+    FrameDecoder decoder;
+    decode(decoder, {fullFrame(254, 0, A), deltaFrame(255, 0, 0x01, B), deltaFrame(0, 0, 0x01, A), fullFrame(1, 0, B)});
+    CHECK(decoder.droppedCount() == 0);
+    CHECK(!decoder.takeResyncRequest());
+
+    decode(decoder, {fullFrame(4, 0, A)}); // 2 and 3 lost
+    CHECK(decoder.droppedCount() == 2);
+    CHECK(!decoder.takeResyncRequest()); // a full frame needs no help
+
+    decode(decoder, {fullFrame(253, 0, A), deltaFrame(1, 0, 0x01, B)}); // 254, 255, 0 lost
+    CHECK(decoder.droppedCount() == 2 + 248 + 3);
+    CHECK(decoder.takeResyncRequest());
+
+    // An ASCII line in between restarts the count.
+    FrameDecoder mixed;
+    decode(mixed, {fullFrame(10, 0, A), dataLine(0, B), fullFrame(50, 0, A)});
+    CHECK(mixed.droppedCount() == 0);
+}
+
+// The handshake reply switches the decoder's view of the link.
+static void testHandshake() {
+    FrameDecoder decoder;
+    decode(decoder, {"VMX,OK,BIN,FILTERED,METER\r\n"});
+    CHECK(decoder.binaryMode() && decoder.filteredInput() && decoder.takesMeters());
+    decode(decoder, {"VMX,OK,ASCII\n"});
+    CHECK(!decoder.binaryMode() && !decoder.takesMeters());
+    CHECK(decoder.frameCount() == 0 && decoder.errorCount() == 0);
+}
+
+int main() {
+    testEverySplit();
+    testBadCrcResync();
+    testSyncByteInLine();
+    testDeltaMerge();
+    testSequence();
+    testHandshake();
+    if (failures) {
+        std::cerr << failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << "frame_decoder_test: all checks passed\n";
+    return 0;
+}
@@ -10,77 +10,251 @@
 #include <thread>
 #include <chrono>
 #include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <array>
 #include <fstream>
 #include <iomanip>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+
+#include "volmix_taper.h"
 
 const char* SERIAL_PORT = "/dev/ttyUSB0";
 const int BAUD_RATE = B115200;
 const int THRESHOLD = 8;
 const std::string CONFIG_FILE = "volmix.conf";
 
+// --- TAPERS ---
+// Fader position straight to the value wpctl takes, in 1/10000ths, from tables
+// built at compile time from the curves in volmix_taper.h. wpctl's scale is
+// cubic (gain = value^3), so each entry is the cube root of the taper's gain.
+const int VOL_ONE = 10000;
+
+struct WpctlTable {
+    int vol[ADC_STEPS];
+    constexpr explicit WpctlTable(Taper taper) : vol{} {
+        for (int raw = 0; raw < ADC_STEPS; raw++) vol[raw] = static_cast<int>(constexprCbrt(taperCurve(taper, raw)) * VOL_ONE + 0.5);
+    }
+};
+
+constexpr WpctlTable WPCTL_TABLES[] = {WpctlTable(Taper::Cubic), WpctlTable(Taper::Linear), WpctlTable(Taper::Decibel)};
+static_assert(WPCTL_TABLES[0].vol[ADC_FULL_SCALE] == VOL_ONE && WPCTL_TABLES[1].vol[ADC_FULL_SCALE] == VOL_ONE &&
+              WPCTL_TABLES[2].vol[ADC_FULL_SCALE] == VOL_ONE, "tapers must reach unity at full scale");
+
 struct FaderConfig {
     std::string id;
     std::string alias;
 };
 
-std::mutex uiMutex;
+// Guards layeredMapping, which the serial, render and input threads all read.
+std::mutex mappingMutex;
+// Guards the terminal. The serial thread never takes it.
+std::mutex termMutex;
 std::map<int, std::map<int, FaderConfig>> layeredMapping;
-std::vector<int> currentPercents(9, 0);
-std::vector<int> rawDebugVals(9, 0);
-int activeLayer = 0;
-bool isSerialAlive = false;
-
-// --- UI HELPERS ---
-std::string getBar(int percent, std::string label) {
-    int width = 8;
-    int filled = (percent * width) / 100;
-    std::string bar = label + " [";
-    for (int i = 0; i < width; ++i) bar += (i < filled) ? "#" : " ";
-    return (percent == 0) ? label + " [ MUTE ]" : bar + "]";
+// Published by the serial thread, drawn by the render thread. [1] is the
+// master fader, [2..8] the channel faders.
+std::array<std::atomic<int>, 9> currentPercents{};
+std::array<std::atomic<int>, 9> rawDebugVals{};
+// [0] is the master fader, [1..7] the channel faders.
+Taper faderTapers[8] = {};
+std::atomic<int> activeLayer{0};
+std::atomic<bool> isSerialAlive{false};
+
+// --- TARGETS ---
+// What `ls` lists: one `wpctl status`, parsed here instead of through a shell
+// and awk, and kept until the next `ls`. Only touched by the input thread.
+// This tool reads the controller itself, in place of volmix_backend, so there
+// is no backend to ask for LIST_NODES; wpctl is also what sets the volumes.
+struct TargetEntry {
+    const char* kind;
+    std::string line; // "48. Built-in Audio Analog Stereo [vol: 0.40]"
+};
+std::vector<TargetEntry> targetCache;
+
+void refreshTargets() {
+    FILE* pipe = popen("wpctl status", "r");
+    if (!pipe) return;
+    targetCache.clear();
+
+    char buffer[1024];
+    bool inAudio = false;
+    const char* kind = nullptr;
+    while (fgets(buffer, sizeof(buffer), pipe) != NULL) {
+        std::string line(buffer);
+        while (!line.empty() && isspace(static_cast<unsigned char>(line.back()))) line.pop_back();
+        if (line.empty()) continue;
+
+        // Top level sections ("Audio", "Video", "Settings") start at column 0.
+        if (isalpha(static_cast<unsigned char>(line[0]))) {
+            inAudio = line.rfind("Audio", 0) == 0;
+            kind = nullptr;
+            continue;
+        }
+        if (line.find("Sinks:") != std::string::npos) { kind = "[OUT]"; continue; }
+        if (line.find("Sources:") != std::string::npos) { kind = "[IN ]"; continue; }
+        if (line.find("Filters:") != std::string::npos) { kind = "[MIC]"; continue; }
+        if (line.find("Streams:") != std::string::npos) { kind = "[APP]"; continue; }
+        if (line.find(":") != std::string::npos && line.find(". ") == std::string::npos) { kind = nullptr; continue; }
+        if (!inAudio || !kind) continue;
+
+        // "  │  *   48. Built-in Audio Analog Stereo   [vol: 0.40]"
+        size_t digits = line.find_first_of("0123456789");
+        if (digits == std::string::npos) continue;
+        size_t dot = line.find_first_not_of("0123456789", digits);
+        if (dot == std::string::npos || line.compare(dot, 2, ". ") != 0) continue;
+        targetCache.push_back({kind, line.substr(digits)});
+    }
+    pclose(pipe);
 }
 
-void refreshUI() {
-    std::lock_guard<std::mutex> lock(uiMutex);
-    std::cout << "\033[s\033[1;1H\033[1;37;44m";
-    std::cout << " L" << activeLayer << " | " << (isSerialAlive ? "LIVE" : "DEAD") << " | ";
-    std::cout << getBar(currentPercents[1], "MST") << " " << currentPercents[1] << "% | ";
-    for(int i = 1; i <= 7; i++) {
-        std::string label = (layeredMapping[activeLayer].count(i)) ? layeredMapping[activeLayer][i].alias : "F" + std::to_string(i);
-        std::cout << getBar(currentPercents[i+1], label) << " ";
+// --- RENDERER ---
+// The status bar on the first terminal row. The serial thread only publishes
+// state and bumps uiVersion; the render thread draws at most RENDER_FPS frames
+// a second and writes only the cells that differ from the previous frame.
+const int RENDER_FPS = 30;
+const int BAR_WIDTH = 8; // fits "  MUTE  "
+const int LABEL_WIDTH = 8;
+// " L0 | LIVE | " + "MST [########] 100% | " + 7 x "label    [########] "
+const int STATUS_WIDTH = 13 + 22 + 7 * (LABEL_WIDTH + BAR_WIDTH + 4);
+
+std::mutex renderMutex;
+std::condition_variable renderCv;
+uint64_t uiVersion = 0;
+bool redrawAll = true; // the screen was cleared; the previous frame is gone
+
+void publishUI() {
+    {
+        std::lock_guard<std::mutex> lock(renderMutex);
+        uiVersion++;
     }
-    std::cout << "\033[0m\033[K\033[u" << std::flush;
+    renderCv.notify_one();
 }
 
-void showFullInterface() {
-    std::lock_guard<std::mutex> lock(uiMutex);
-    system("clear");
-    std::cout << "\n\033[1;36m========= VOLUME CONTROL TARGETS =========\033[0m" << std::endl;
+void requestFullRedraw() {
+    {
+        std::lock_guard<std::mutex> lock(renderMutex);
+        redrawAll = true;
+    }
+    renderCv.notify_one();
+}
 
-    // Revised AWK: Catches indented IDs specifically for Focusrite/Filters
-    std::string awkCmd = "wpctl status | awk '"
-    "/Sinks:/   {type=\"[OUT]\"} "
-    "/Sources:/ {type=\"[IN ]\"} "
-    "/Filters:/ {type=\"[MIC]\"} "
-    "/Streams:/ {type=\"[APP]\"} "
-    "/Settings/ {type=\"\"} "
-    "type != \"\" && /[0-9]+\\./ { "
-    "  sub(/^[[:space:]\\*]*/, \"\"); "
-    "  print type \" \" $0 "
-    "}'";
+// Writes exactly width + BAR_WIDTH + 3 cells.
+char* putBar(char* p, int percent, const char* label, size_t labelLen, size_t width = LABEL_WIDTH) {
+    labelLen = std::min(labelLen, width);
+    memcpy(p, label, labelLen);
+    memset(p + labelLen, ' ', width - labelLen);
+    p += width;
+    *p++ = ' ';
+    *p++ = '[';
+    if (percent == 0) {
+        memcpy(p, "  MUTE  ", BAR_WIDTH);
+    } else {
+        int filled = (percent * BAR_WIDTH) / 100;
+        for (int i = 0; i < BAR_WIDTH; ++i) p[i] = i < filled ? '#' : ' ';
+    }
+    p += BAR_WIDTH;
+    *p++ = ']';
+    return p;
+}
 
-    system(awkCmd.c_str());
+void composeStatus(char* cells) {
+    char* p = cells;
+    int layer = activeLayer.load(std::memory_order_relaxed);
+    // One digit keeps the prefix at its 13 cells whatever the firmware sent.
+    p += snprintf(p, 14, " L%d | %s | ", std::clamp(layer, 0, 9), isSerialAlive ? "LIVE" : "DEAD");
+    int master = currentPercents[1].load(std::memory_order_relaxed);
+    p = putBar(p, master, "MST", 3, 3);
+    char tail[16];
+    int tailLen = snprintf(tail, sizeof(tail), " %3d%% | ", master);
+    memcpy(p, tail, tailLen);
+    p += tailLen;
+
+    std::lock_guard<std::mutex> lock(mappingMutex);
+    auto faders = layeredMapping.find(layer);
+    for (int i = 1; i <= 7; i++) {
+        char fallback[3] = {'F', static_cast<char>('0' + i), 0};
+        const char* label = fallback;
+        size_t len = 2;
+        if (faders != layeredMapping.end()) {
+            auto it = faders->second.find(i);
+            if (it != faders->second.end()) { label = it->second.alias.data(); len = it->second.alias.size(); }
+        }
+        p = putBar(p, currentPercents[i+1].load(std::memory_order_relaxed), label, len);
+        *p++ = ' ';
+    }
+}
+
+void renderThread() {
+    char prev[STATUS_WIDTH];
+    char next[STATUS_WIDTH];
+    // Worst case is every other cell changing: a cursor move per cell.
+    const char* prefix = "\033[s\033[1;37;44m";
+    std::string out;
+    out.reserve(STATUS_WIDTH * 8);
+    const auto interval = std::chrono::microseconds(1000000 / RENDER_FPS);
+    auto nextFrame = std::chrono::steady_clock::now();
+    uint64_t drawn = 0;
+
+    std::unique_lock<std::mutex> lock(renderMutex);
+    while (true) {
+        renderCv.wait(lock, [&] { return uiVersion != drawn || redrawAll; });
+        lock.unlock();
+        // Whatever arrives while we wait here lands in this frame.
+        std::this_thread::sleep_until(nextFrame);
+        lock.lock();
+        drawn = uiVersion;
+        bool full = redrawAll;
+        redrawAll = false;
+        lock.unlock();
+
+        composeStatus(next);
+        out.assign(prefix);
+        for (int col = 0; col < STATUS_WIDTH;) {
+            if (!full && next[col] == prev[col]) { col++; continue; }
+            int end = col + 1;
+            while (end < STATUS_WIDTH && (full || next[end] != prev[end])) end++;
+            char move[16];
+            out.append(move, snprintf(move, sizeof(move), "\033[1;%dH", col + 1));
+            out.append(next + col, end - col);
+            col = end;
+        }
+        if (out.size() > strlen(prefix)) {
+            out += full ? "\033[0m\033[K\033[u" : "\033[0m\033[u";
+            std::lock_guard<std::mutex> term(termMutex);
+            std::cout.flush();
+            ssize_t ignored = write(STDOUT_FILENO, out.data(), out.size());
+            (void)ignored;
+        }
+        memcpy(prev, next, STATUS_WIDTH);
+        nextFrame = std::chrono::steady_clock::now() + interval;
+        lock.lock();
+    }
+}
+
+void showFullInterface() {
+    std::lock_guard<std::mutex> term(termMutex);
+    std::cout << "\033[H\033[2J";
+    std::cout << "\n\033[1;36m========= VOLUME CONTROL TARGETS =========\033[0m" << std::endl;
+    for (auto const& target : targetCache) std::cout << target.kind << " " << target.line << "\n";
 
     std::cout << "\n\033[1;33m--- LIVE DEBUG ---\033[0m" << std::endl;
     std::cout << "Raw ADC:  M:" << rawDebugVals[1] << " ";
     for(int i=1; i<=7; i++) std::cout << "F" << i << ":" << rawDebugVals[i+1] << " ";
     std::cout << "\nTargets:  M:DEFAULT ";
-    for(int i=1; i<=7; i++) {
-        std::string target = layeredMapping[activeLayer].count(i) ? layeredMapping[activeLayer][i].id : "---";
-        std::cout << "F" << i << ":" << target << " ";
+    {
+        std::lock_guard<std::mutex> lock(mappingMutex);
+        auto& faders = layeredMapping[activeLayer];
+        for(int i=1; i<=7; i++) {
+            std::string target = faders.count(i) ? faders[i].id : "---";
+            std::cout << "F" << i << ":" << target << " ";
+        }
     }
     std::cout << "\n\033[1;36m==========================================\033[0m" << std::endl;
     std::cout << "Cmds: [L]-[F]-[ID]-[Name] | [L]-[F]-[ID] | unbind [L]-[F] | ls | exit" << std::endl;
     std::cout << "Command: " << std::flush;
+    requestFullRedraw();
 }
 
 void saveConfig() {
@@ -90,17 +264,52 @@ void saveConfig() {
             f_out << lay << " " << f << " " << cfg.id << " " << cfg.alias << "\n";
         }
     }
+    for (int i = 0; i < 8; i++) {
+        if (faderTapers[i] == Taper::Cubic) continue;
+        f_out << "taper " << (i == 0 ? "master" : std::to_string(i)) << " " << TAPER_NAMES[static_cast<int>(faderTapers[i])] << "\n";
+    }
 }
 
+void loadConfig() {
+    std::ifstream f_in(CONFIG_FILE);
+    std::string line;
+    while (std::getline(f_in, line)) {
+        std::stringstream ss(line);
+        std::string first;
+        if (!(ss >> first)) continue;
+        if (first == "taper") {
+            std::string fader, name;
+            if (!(ss >> fader >> name)) continue;
+            int idx = fader == "master" ? 0 : std::atoi(fader.c_str());
+            if (idx < 0 || idx > 7 || (idx == 0 && fader != "master")) continue;
+            parseTaper(name, faderTapers[idx]);
+            continue;
+        }
+        int cl, cf; std::string cid, calias;
+        try { cl = std::stoi(first); } catch (...) { continue; }
+        if (ss >> cf >> cid >> calias) layeredMapping[cl][cf] = {cid, calias};
+    }
+}
+
+// Last value sent to each target, so a command only goes out when the audible
+// volume changes. Only touched by the serial thread.
+std::map<std::string, int> lastOutput;
+
 void applyVolume(std::string targetId, int rawValue, int faderIdx) {
-    int percent = std::clamp((rawValue * 100) / 1014, 0, 100);
-    currentPercents[faderIdx] = percent;
+    int raw = std::clamp(rawValue, 0, ADC_STEPS - 1);
+    currentPercents[faderIdx] = std::min(raw, ADC_FULL_SCALE) * 100 / ADC_FULL_SCALE;
     if (targetId.empty() || targetId == "---") return;
 
-    double vol = percent / 100.0;
+    int vol = WPCTL_TABLES[static_cast<int>(faderTapers[faderIdx - 1])].vol[raw];
+    auto it = lastOutput.find(targetId);
+    if (it != lastOutput.end() && it->second == vol) return;
+    lastOutput[targetId] = vol;
+
+    char value[16];
+    snprintf(value, sizeof(value), "%d.%04d", vol / VOL_ONE, vol % VOL_ONE);
     std::stringstream cmd;
-    cmd << "wpctl set-volume " << targetId << " " << std::fixed << std::setprecision(2) << vol << " && ";
-    cmd << "wpctl set-mute " << targetId << " " << (percent == 0 ? "1" : "0");
+    cmd << "wpctl set-volume " << targetId << " " << value << " && ";
+    cmd << "wpctl set-mute " << targetId << " " << (vol == 0 ? "1" : "0");
     system((cmd.str() + " > /dev/null 2>&1 &").c_str());
 }
 
@@ -115,6 +324,7 @@ void serialThread() {
     tcsetattr(fd, TCSANOW, &tty);
 
     isSerialAlive = true;
+    publishUI();
     std::vector<int> lastVals(10, -1);
     std::string buffer; char c;
     while (read(fd, &c, 1) > 0) {
@@ -127,6 +337,7 @@ void serialThread() {
                 }
                 if (vals.size() >= 9) {
                     activeLayer = vals[0];
+                    int layer = vals[0];
                     for(int i = 1; i <= 8; i++) rawDebugVals[i] = vals[i];
 
                     // Master + Master Mute
@@ -138,39 +349,41 @@ void serialThread() {
                     for (int i = 1; i <= 7; i++) {
                         if (std::abs(vals[i+1] - lastVals[i+1]) > THRESHOLD) {
                             std::string target = "";
-                            { std::lock_guard<std::mutex> lock(uiMutex);
-                                if (layeredMapping[activeLayer].count(i)) target = layeredMapping[activeLayer][i].id; }
-                                applyVolume(target, vals[i+1], i+1);
+                            { std::lock_guard<std::mutex> lock(mappingMutex);
+                                if (layeredMapping[layer].count(i)) target = layeredMapping[layer][i].id; }
+                            applyVolume(target, vals[i+1], i+1);
                             lastVals[i+1] = vals[i+1];
                         }
                     }
-                    refreshUI();
+                    publishUI();
                 }
             }
             buffer.clear();
         } else if (c != '\r') buffer += c;
     }
     isSerialAlive = false; close(fd);
+    publishUI();
 }
 
 int main() {
-    std::ifstream f_in(CONFIG_FILE);
-    int cl, cf; std::string cid, calias;
-    while (f_in >> cl >> cf >> cid >> calias) { layeredMapping[cl][cf] = {cid, calias}; }
+    loadConfig();
+
+    refreshTargets();
 
+    std::thread rThread(renderThread); rThread.detach();
     std::thread sThread(serialThread); sThread.detach();
     std::this_thread::sleep_for(std::chrono::milliseconds(500));
     showFullInterface();
 
     std::string input;
     while (std::getline(std::cin, input)) {
-        if (input == "ls") { showFullInterface(); continue; }
+        if (input == "ls") { refreshTargets(); showFullInterface(); continue; }
         if (input == "exit") break;
 
         if (input.substr(0, 7) == "unbind ") {
             int ul, uf; char ud; std::stringstream ss(input.substr(7));
             if (ss >> ul >> ud >> uf) {
-                { std::lock_guard<std::mutex> lock(uiMutex); layeredMapping[ul].erase(uf); }
+                { std::lock_guard<std::mutex> lock(mappingMutex); layeredMapping[ul].erase(uf); }
                 saveConfig();
                 std::cout << "\n\033[1;32mUnbound L" << ul << " F" << uf << "\033[0m" << std::endl;
             }
@@ -182,7 +395,7 @@ int main() {
 
             if (pss >> l >> f >> id) {
                 if (!(pss >> name)) name = "F" + std::to_string(f);
-                { std::lock_guard<std::mutex> lock(uiMutex); layeredMapping[l][f] = {id, name}; }
+                { std::lock_guard<std::mutex> lock(mappingMutex); layeredMapping[l][f] = {id, name}; }
                 saveConfig();
                 std::cout << "\n\033[1;32mBound L" << l << " F" << f << " to " << id << " (" << name << ")\033[0m" << std::endl;
             }
@@ -13,83 +13,633 @@
 #include <fstream>
 #include <iomanip>
 #include <sys/stat.h>
-#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+#include <dirent.h>
+#include <climits>
+#include <sys/socket.h>
+#include <sys/un.h>
 #include <cstdlib>
-#include <regex>
+#include <unordered_map>
+#include <functional>
+#include <condition_variable>
+#include <deque>
+#include <csignal>
+#include <memory>
+#include <atomic>
+#include <array>
+#include <tuple>
+#include <cerrno>
+#include <cstring>
+#include <charconv>
+#include <cmath>
+#include <iterator>
 
-const char* SERIAL_PORT = "/dev/ttyUSB0";
+// The direct PipeWire backend (registry, drift tracking, meters) is opt-in:
+// it has not yet been built against libpipewire-0.3 and tried on a live
+// daemon. Build with -DVOLMIX_USE_PIPEWIRE=1 and the pkg-config flags to use
+// it; the default build drives volumes through wpctl.
+#ifndef VOLMIX_USE_PIPEWIRE
+#define VOLMIX_USE_PIPEWIRE 0
+#endif
+
+#if VOLMIX_USE_PIPEWIRE
+#include <pipewire/pipewire.h>
+#include <pipewire/extensions/metadata.h>
+#include <spa/param/props.h>
+#include <spa/param/audio/raw.h>
+#include <spa/param/audio/format-utils.h>
+#include <spa/pod/builder.h>
+#include <spa/pod/iter.h>
+#endif
+
+#include "volmix_frame.h"
+#include "volmix_taper.h"
+
+// Controllers are found by watching /dev; --port (repeatable) pins the backend
+// to the given devices instead.
+std::vector<std::string> serialPorts;
+const char* SERIAL_BY_ID_DIR = "/dev/serial/by-id";
+// USB "vendor:product" ids of the boards the firmware runs on: Arduino's
+// own (any product) and the CH340 and FTDI bridges on Nano clones.
+// VOLMIX_USB_IDS ("vid:pid,...", "vid:*" for any product) adds more.
+const char* CONTROLLER_USB_IDS[] = {"2341:*", "2a03:*", "1a86:7523", "0403:6001"};
+const int MAX_OPEN_ATTEMPTS = 6; // busy devices: retried after 1, 2, 4 ... 32 s, then left alone
 const int BAUD_RATE = B115200;
 const int THRESHOLD = 8;
+const int MAX_CONTROLLERS = 8; // config sections, including the default one
+const size_t CONTROLLER_MAX_QUEUED = 4096; // unsent bytes kept for a controller that is not reading
+
+// Volume targets are PipeWire node ids. Id 0 is the core object and can never
+// be a target, so it stands for "whatever the default sink is".
+using TargetId = uint32_t;
+const TargetId DEFAULT_SINK_TARGET = 0;
+
+std::string targetName(TargetId target) {
+    return target == DEFAULT_SINK_TARGET ? "@DEFAULT_AUDIO_SINK@" : std::to_string(target);
+}
+
+// Must be @DEFAULT or a numeric ID > 10; anything else ("---", ghost ids) is
+// not something we can set a volume on.
+bool parseTarget(const std::string& targetId, TargetId& out) {
+    if (targetId == "@DEFAULT_AUDIO_SINK@") { out = DEFAULT_SINK_TARGET; return true; }
+    if (targetId.length() < 2 || !std::all_of(targetId.begin(), targetId.end(), ::isdigit)) return false;
+    auto res = std::from_chars(targetId.data(), targetId.data() + targetId.size(), out);
+    return res.ec == std::errc() && out != DEFAULT_SINK_TARGET;
+}
+
+// --- TAPERS ---
+// Curves and tables are in volmix_taper.h.
+
+// [0] is the master fader, [1..7] the channel faders.
+using FaderTapers = std::array<Taper, NUM_FADERS + 1>;
 
 struct FaderConfig {
     std::string lastKnownId;
     std::string resolvedName;
+    // The line as written in the config, used to diff reloads.
+    std::string configuredId;
+    std::string alias;
+};
+
+using LayerMap = std::map<int, std::multimap<int, FaderConfig>>;
+
+// One per "controller <name> <match>" section of the config, each with its own
+// layers, faders and tapers. [0] holds the lines before the first section and
+// drives every controller that no section claims.
+struct ControllerBindings {
+    std::string name;
+    std::string match; // substring of the device's /dev/serial/by-id name
+    LayerMap layers;
+    FaderTapers tapers;
+    ControllerBindings() { tapers.fill(Taper::Cubic); }
+};
+
+using BindingSet = std::vector<ControllerBindings>;
+
+// Compiled form of the bindings for the per-frame path: one contiguous span of
+// validated node ids per [layer][fader], so a fader move is two index lookups,
+// plus each fader's taper. A group binding is just a longer span.
+class RoutingTable {
+public:
+    struct Span {
+        const TargetId* first;
+        const TargetId* last;
+        const TargetId* begin() const { return first; }
+        const TargetId* end() const { return last; }
+    };
+
+    RoutingTable() { tapers.fill(Taper::Cubic); }
+
+    RoutingTable(const LayerMap& mapping, const FaderTapers& tapers) : tapers(tapers) {
+        for (auto const& [layer, faders] : mapping) {
+            if (layer >= 0) layers = std::max(layers, layer + 1);
+        }
+        spans.assign(static_cast<size_t>(layers) * NUM_FADERS, {0, 0});
+        for (int layer = 0; layer < layers; layer++) {
+            auto it = mapping.find(layer);
+            if (it == mapping.end()) continue;
+            for (int fader = 1; fader <= NUM_FADERS; fader++) {
+                auto& span = spans[slot(layer, fader)];
+                span.first = static_cast<uint32_t>(targets.size());
+                auto range = it->second.equal_range(fader);
+                for (auto b = range.first; b != range.second; ++b) {
+                    TargetId target;
+                    if (!parseTarget(b->second.lastKnownId, target)) continue;
+                    // A node bound directly and through a group is set once.
+                    if (std::find(targets.begin() + span.first, targets.end(), target) != targets.end()) continue;
+                    targets.push_back(target);
+                }
+                span.second = static_cast<uint32_t>(targets.size());
+            }
+        }
+    }
+
+    Span route(int layer, int fader) const {
+        if (layer < 0 || layer >= layers || fader < 1 || fader > NUM_FADERS) return {nullptr, nullptr};
+        auto [first, last] = spans[slot(layer, fader)];
+        return {targets.data() + first, targets.data() + last};
+    }
+
+    // fader 0 is the master.
+    Gain gain(int fader, int raw) const { return taperGain(tapers[fader], raw); }
+
+private:
+    static size_t slot(int layer, int fader) { return static_cast<size_t>(layer) * NUM_FADERS + (fader - 1); }
+
+    int layers = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> spans;
+    std::vector<TargetId> targets;
+    FaderTapers tapers;
+};
+
+// Every config section compiled, in config order.
+struct Routing {
+    std::vector<RoutingTable> tables;
+    std::vector<std::string> names;
+    std::vector<std::string> matches;
+
+    Routing() : tables(1), names(1), matches(1) {}
+
+    explicit Routing(const BindingSet& set) {
+        for (auto const& section : set) {
+            tables.emplace_back(section.layers, section.tapers);
+            names.push_back(section.name);
+            matches.push_back(section.match);
+        }
+    }
+
+    // The first section whose match occurs in the device id, else the default.
+    int sectionFor(const std::string& deviceId) const {
+        for (size_t i = 1; i < matches.size(); i++) {
+            if (deviceId.find(matches[i]) != std::string::npos) return static_cast<int>(i);
+        }
+        return 0;
+    }
+};
+
+// The config-side bindings, and every reader of the compiled Routing, live on
+// the event loop thread, so publishing needs no atomics. Each change is
+// compiled into a fresh immutable Routing; a controller holds on to the one it
+// is using (its meter tables point into it) until it sees a newer one.
+BindingSet bindings(1);
+std::shared_ptr<const Routing> routingSnapshot = std::make_shared<const Routing>();
+
+std::shared_ptr<const Routing> currentRouting() {
+    return routingSnapshot;
+}
+
+void publishBindings(BindingSet set) {
+    bindings = std::move(set);
+    routingSnapshot = std::make_shared<const Routing>(bindings);
+}
+
+// Live state of one config section, written by the main loop only.
+// Index 1 is the master, i+1 fader i.
+struct ControllerState {
+    std::array<std::atomic<int>, 9> percents; // fader position, -1 until the fader has reported
+    std::array<std::atomic<int>, 9> raw;      // ADC reading behind it
+    std::atomic<int> layer{0};
+    std::atomic<int> connected{0};            // devices open for this section
+    ControllerState() {
+        for (auto& pct : percents) pct = -1;
+        for (auto& r : raw) r = -1;
+    }
+};
+std::array<ControllerState, MAX_CONTROLLERS> controllerStates;
+
+// Work handed to the main loop by the PipeWire thread: set under wakeMutex,
+// then mainEventFd wakes the loop.
+std::mutex wakeMutex;
+int mainEventFd = -1;
+bool registryDirty = false;
+bool connectionChanged = false;
+std::vector<TargetId> pendingReassert;
+
+void wakeMainLoop() {
+    if (mainEventFd < 0) return;
+    uint64_t one = 1;
+    ssize_t ignored = write(mainEventFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+// Tells the control socket that the live state changed. Several changes
+// before the loop gets to it go out as one update.
+int controlEventFd = -1;
+std::atomic<bool> nodesChanged{false};
+
+void notifyControlSocket() {
+    if (controlEventFd < 0) return;
+    uint64_t one = 1;
+    ssize_t ignored = write(controlEventFd, &one, sizeof(one));
+    (void)ignored;
+}
+
+void notifyRegistryChanged() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        registryDirty = true;
+    }
+    wakeMainLoop();
+    nodesChanged = true;
+    notifyControlSocket();
+}
+
+// The backend lost its connection to the audio server, or has it back.
+void notifyConnectionChange() {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        connectionChanged = true;
+    }
+    wakeMainLoop();
+}
+
+// Someone else changed the volume of target (or it is a new default sink).
+void notifyExternalChange(TargetId target) {
+    {
+        std::lock_guard<std::mutex> lock(wakeMutex);
+        pendingReassert.push_back(target);
+    }
+    wakeMainLoop();
+}
+
+// --- STATS ---
+
+// Log-linear buckets in the style of HdrHistogram: 16 sub-buckets per power of
+// two, so a bucket's lower bound is within 1/16 of any value in it. Recording
+// is a couple of relaxed atomic adds and never blocks.
+class LatencyHistogram {
+public:
+    void record(uint64_t ns) {
+        buckets[bucketFor(ns)].fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t seen = max.load(std::memory_order_relaxed);
+        while (ns > seen && !max.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {}
+    }
+
+    void record(std::chrono::steady_clock::duration d) {
+        record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count()));
+    }
+
+    uint64_t count() const { return total.load(std::memory_order_relaxed); }
+    uint64_t maxNs() const { return max.load(std::memory_order_relaxed); }
+    uint64_t meanNs() const { uint64_t n = count(); return n ? sum.load(std::memory_order_relaxed) / n : 0; }
+
+    uint64_t percentileNs(double p) const {
+        uint64_t n = count();
+        if (n == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p * static_cast<double>(n - 1)) + 1, seen = 0;
+        for (size_t b = 0; b < BUCKETS; b++) {
+            seen += buckets[b].load(std::memory_order_relaxed);
+            if (seen >= rank) return std::min(lowerBound(b), maxNs());
+        }
+        return maxNs();
+    }
+
+private:
+    static constexpr int SUB_BITS = 4;
+    static constexpr uint64_t SUB = 1 << SUB_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB;
+
+    static size_t bucketFor(uint64_t v) {
+        if (v < SUB) return static_cast<size_t>(v);
+        int shift = 63 - __builtin_clzll(v) - SUB_BITS;
+        return static_cast<size_t>((shift + 1) * SUB + ((v >> shift) & (SUB - 1)));
+    }
+
+    static uint64_t lowerBound(size_t b) {
+        if (b < SUB) return b;
+        return (SUB + b % SUB) << (b / SUB - 1);
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> buckets{};
+    std::atomic<uint64_t> total{0}, sum{0}, max{0};
 };
 
-std::mutex dataMutex;
-std::map<int, std::multimap<int, FaderConfig>> layeredMapping;
-std::vector<int> currentPercents(9, 0); 
-int activeLayer = 0;
-bool isSerialAlive = false;
+// Counters and stage timings for serial read -> parse -> route -> apply.
+struct PipelineStats {
+    std::atomic<uint64_t> framesReceived{0};
+    std::atomic<uint64_t> framesDropped{0};  // sequence gaps on the binary link
+    std::atomic<uint64_t> framesCorrupt{0};  // binary frames failing their CRC
+    std::atomic<uint64_t> parseErrors{0};    // ASCII lines that did not parse
+    std::atomic<uint64_t> commandsSubmitted{0};
+    std::atomic<uint64_t> commandsCoalesced{0}; // overwrote a value not yet sent
+    std::atomic<uint64_t> commandsIssued{0};
+    std::atomic<uint64_t> refreshes{0};
+    std::atomic<uint64_t> layerSwitches{0};
+
+    LatencyHistogram parse;   // decoding one read() worth of bytes, routing excluded
+    LatencyHistogram route;   // one frame: routing table lookup and submits
+    LatencyHistogram submit;  // one frame's submits, including the scheduler lock
+    LatencyHistogram queued;  // first submit of a value until its backend call
+    LatencyHistogram apply;   // one backend call, which takes a whole batch
+    LatencyHistogram refresh; // config load or id / registry re-resolution
+};
+
+PipelineStats stats;
+const auto startTime = std::chrono::steady_clock::now();
+
+std::string formatStats() {
+    std::ostringstream out;
+    auto uptime = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::steady_clock::now() - startTime);
+    out << "uptime " << uptime.count() << "s\n"
+        << "frames: received " << stats.framesReceived << ", dropped " << stats.framesDropped
+        << ", corrupt " << stats.framesCorrupt << ", parse errors " << stats.parseErrors << "\n"
+        << "commands: submitted " << stats.commandsSubmitted << ", coalesced " << stats.commandsCoalesced
+        << ", issued " << stats.commandsIssued << "\n"
+        << "refreshes: " << stats.refreshes << ", layer switches " << stats.layerSwitches << "\n"
+        << "stage        count     p50 us     p99 us     max us    mean us\n";
+    std::pair<const char*, const LatencyHistogram*> stages[] = {
+        {"parse", &stats.parse}, {"route", &stats.route}, {"submit", &stats.submit},
+        {"queued", &stats.queued}, {"apply", &stats.apply}, {"refresh", &stats.refresh},
+    };
+    out << std::fixed << std::setprecision(1);
+    for (auto [name, h] : stages) {
+        out << std::left << std::setw(8) << name << std::right << std::setw(10) << h->count()
+            << std::setw(11) << h->percentileNs(0.5) / 1e3 << std::setw(11) << h->percentileNs(0.99) / 1e3
+            << std::setw(11) << h->maxNs() / 1e3 << std::setw(11) << h->meanNs() / 1e3 << "\n";
+    }
+    return out.str();
+}
+
+// Times a scope into a histogram.
+class ScopedTimer {
+public:
+    explicit ScopedTimer(LatencyHistogram& h) : h(h), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { h.record(std::chrono::steady_clock::now() - start); }
+
+private:
+    LatencyHistogram& h;
+    std::chrono::steady_clock::time_point start;
+};
 
 // --- PIPEWIRE DYNAMIC RESOLVER ---
 
-std::string getPwInfo(std::string searchFor, bool findName) {
+struct NodeInfo {
+    uint32_t id = 0;
+    std::string name;        // node.name
+    std::string mediaClass;
+    std::string appName;
+    std::string displayName; // what wpctl status prints for the node
+};
+
+// In-memory view of the audio graph. Filled from PipeWire registry events when
+// the native backend is active, or from a single `wpctl status` parse otherwise.
+// Both directions are hash lookups; the GUI's truncated aliases are indexed too.
+class NodeRegistry {
+public:
+    void add(const NodeInfo& info) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = byId.find(info.id);
+            if (it != byId.end()) unindexLocked(it->second);
+            byId[info.id] = info;
+            indexLocked(info);
+        }
+        notify();
+    }
+
+    void remove(uint32_t id) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = byId.find(id);
+            if (it == byId.end()) return;
+            unindexLocked(it->second);
+            byId.erase(it);
+        }
+        notify();
+    }
+
+    void replaceAll(const std::vector<NodeInfo>& nodes) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            bool same = nodes.size() == byId.size();
+            for (size_t i = 0; same && i < nodes.size(); i++) {
+                auto it = byId.find(nodes[i].id);
+                same = it != byId.end() && it->second.displayName == nodes[i].displayName;
+            }
+            if (same) return;
+            byId.clear();
+            byName.clear();
+            for (const auto& info : nodes) {
+                byId[info.id] = info;
+                indexLocked(info);
+            }
+        }
+        notify();
+    }
+
+    std::string displayName(uint32_t id) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = byId.find(id);
+        return it == byId.end() ? "" : it->second.displayName;
+    }
+
+    // Streams win over devices and newer objects over older ones, so an app
+    // that restarted is picked up under its new ID.
+    uint32_t findByName(const std::string& name) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = byName.find(foldKey(name));
+        if (it == byName.end()) it = byName.find(aliasKey(name));
+        if (it == byName.end()) return 0;
+
+        uint32_t best = 0;
+        bool bestIsStream = false;
+        for (uint32_t id : it->second) {
+            bool isStream = byId.at(id).mediaClass.rfind("Stream/", 0) == 0;
+            if (best == 0 || isStream > bestIsStream || (isStream == bestIsStream && id > best)) {
+                best = id;
+                bestIsStream = isStream;
+            }
+        }
+        return best;
+    }
+
+    bool hasName(uint32_t id, const std::string& name) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = byId.find(id);
+        if (it == byId.end()) return false;
+        auto keys = keysFor(it->second);
+        return std::binary_search(keys.begin(), keys.end(), foldKey(name)) ||
+               std::binary_search(keys.begin(), keys.end(), aliasKey(name));
+    }
+
+    std::vector<NodeInfo> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::vector<NodeInfo> nodes;
+        nodes.reserve(byId.size());
+        for (const auto& [id, info] : byId) nodes.push_back(info);
+        std::sort(nodes.begin(), nodes.end(), [](const NodeInfo& a, const NodeInfo& b) { return a.id < b.id; });
+        return nodes;
+    }
+
+    void setOnChange(std::function<void()> callback) {
+        std::lock_guard<std::mutex> lock(mutex);
+        onChange = std::move(callback);
+    }
+
+private:
+    static std::string foldKey(std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), ::tolower);
+        return s;
+    }
+
+    // volmixgui.py stores at most 10 characters of the name, spaces as '_'.
+    static std::string aliasKey(const std::string& s) {
+        std::string key = foldKey(s.substr(0, 10));
+        std::replace(key.begin(), key.end(), ' ', '_');
+        return key;
+    }
+
+    std::vector<std::string> keysFor(const NodeInfo& info) const {
+        std::vector<std::string> keys;
+        for (const std::string* n : {&info.displayName, &info.name, &info.appName}) {
+            if (n->empty()) continue;
+            keys.push_back(foldKey(*n));
+            keys.push_back(aliasKey(*n));
+        }
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        return keys;
+    }
+
+    void indexLocked(const NodeInfo& info) {
+        for (const auto& key : keysFor(info)) byName[key].push_back(info.id);
+    }
+
+    void unindexLocked(const NodeInfo& info) {
+        for (const auto& key : keysFor(info)) {
+            auto it = byName.find(key);
+            if (it == byName.end()) continue;
+            auto& ids = it->second;
+            ids.erase(std::remove(ids.begin(), ids.end(), info.id), ids.end());
+            if (ids.empty()) byName.erase(it);
+        }
+    }
+
+    void notify() {
+        std::function<void()> callback;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            callback = onChange;
+        }
+        if (callback) callback();
+    }
+
+    mutable std::mutex mutex;
+    std::unordered_map<uint32_t, NodeInfo> byId;
+    std::unordered_map<std::string, std::vector<uint32_t>> byName;
+    std::function<void()> onChange;
+};
+
+NodeRegistry nodeRegistry;
+
+// Fallback when there is no registry connection: one `wpctl status` per refresh.
+void refreshRegistryFromWpctl() {
+    ScopedTimer timer(stats.refresh);
+    stats.refreshes.fetch_add(1, std::memory_order_relaxed);
     FILE* pipe = popen("wpctl status", "r");
-    if (!pipe) return "";
+    if (!pipe) return;
 
     char buffer[1024];
-    std::string lastFoundId = "";
-    std::string lastFoundName = "";
-    
-    // Regex to find: "  123. Name of Application   [vol: 0.50]"
-    // This ensures we only pick objects that actually have volume controls.
-    std::regex lineRegex(R"(^\s*(\d+)\.\s+(.*?)\s*(?:\[.*\])?)");
+    std::vector<NodeInfo> nodes;
+    bool inAudio = false;
+    std::string mediaClass;
 
     while (fgets(buffer, sizeof(buffer), pipe) != NULL) {
         std::string line(buffer);
-        std::smatch match;
-        
-        if (std::regex_search(line, match, lineRegex)) {
-            std::string id = match[1];
-            std::string name = match[2];
-
-            if (findName) {
-                if (id == searchFor) {
-                    pclose(pipe);
-                    return name;
-                }
-            } else {
-                std::string sLower = searchFor;
-                std::string nLower = name;
-                std::transform(sLower.begin(), sLower.end(), sLower.begin(), ::tolower);
-                std::transform(nLower.begin(), nLower.end(), nLower.begin(), ::tolower);
-                
-                if (nLower.find(sLower) != std::string::npos) {
-                    // Update our candidate, but keep looking for better/later matches (streams)
-                    lastFoundId = id;
-                }
-            }
+        while (!line.empty() && isspace(static_cast<unsigned char>(line.back()))) line.pop_back();
+        if (line.empty()) continue;
+
+        // Top level sections ("Audio", "Video", "Settings") start at column 0.
+        if (isalpha(static_cast<unsigned char>(line[0]))) {
+            inAudio = line.rfind("Audio", 0) == 0;
+            mediaClass.clear();
+            continue;
+        }
+        if (line.find("Sinks:") != std::string::npos) { mediaClass = "Audio/Sink"; continue; }
+        if (line.find("Sources:") != std::string::npos) { mediaClass = "Audio/Source"; continue; }
+        if (line.find("Filters:") != std::string::npos) { mediaClass = "Audio/Filter"; continue; }
+        if (line.find("Streams:") != std::string::npos) { mediaClass = "Stream/Audio"; continue; }
+        if (line.find(":") != std::string::npos && line.find(". ") == std::string::npos) { mediaClass.clear(); continue; }
+        if (!inAudio || mediaClass.empty()) continue;
+
+        // "  │  *   48. Built-in Audio Analog Stereo   [vol: 0.40]"
+        size_t digits = line.find_first_of("0123456789");
+        if (digits == std::string::npos) continue;
+        size_t dot = line.find_first_not_of("0123456789", digits);
+        if (dot == std::string::npos || line.compare(dot, 2, ". ") != 0) continue;
+
+        std::string name = line.substr(dot + 2);
+        // Stream port links ("output_FL > Built-in Audio:playback_FL") are not nodes.
+        if (name.find(" > ") != std::string::npos || name.find(" < ") != std::string::npos) continue;
+        if (!name.empty() && name.back() == ']') {
+            size_t bracket = name.rfind('[');
+            if (bracket != std::string::npos) name.erase(bracket);
         }
+        while (!name.empty() && isspace(static_cast<unsigned char>(name.back()))) name.pop_back();
+
+        NodeInfo info;
+        info.id = static_cast<uint32_t>(std::strtoul(line.c_str() + digits, nullptr, 10));
+        info.mediaClass = mediaClass;
+        info.displayName = name;
+        nodes.push_back(info);
     }
     pclose(pipe);
-    return findName ? "" : lastFoundId;
+    nodeRegistry.replaceAll(nodes);
 }
 
-void refreshDynamicIds() {
-    std::lock_guard<std::mutex> lock(dataMutex);
-    for (auto& [layer, faders] : layeredMapping) {
-        for (auto& [faderIdx, cfg] : faders) {
-            if (!cfg.resolvedName.empty()) {
-                std::string newId = getPwInfo(cfg.resolvedName, false);
+// Returns the IDs bindings moved to, so the fader value can be re-applied.
+std::vector<TargetId> refreshDynamicIds() {
+    ScopedTimer timer(stats.refresh);
+    stats.refreshes.fetch_add(1, std::memory_order_relaxed);
+    std::vector<TargetId> moved;
+    BindingSet set = bindings;
+    for (auto& section : set) {
+        for (auto& [layer, faders] : section.layers) {
+            for (auto& [faderIdx, cfg] : faders) {
+                if (cfg.resolvedName.empty()) continue;
+                // A sink and its monitor source can share a name; stay put while
+                // the bound node is still alive.
+                uint32_t current = static_cast<uint32_t>(std::strtoul(cfg.lastKnownId.c_str(), nullptr, 10));
+                if (current && nodeRegistry.hasName(current, cfg.resolvedName)) continue;
+                uint32_t found = nodeRegistry.findByName(cfg.resolvedName);
+                std::string newId = found ? std::to_string(found) : "";
                 // Only update if we found a valid ID and it's not a "ghost" ID like 1 or 0
                 if (!newId.empty() && newId.length() > 1 && newId != cfg.lastKnownId) {
                     std::cout << "[DEBUG] Resolved '" << cfg.resolvedName << "' -> ID: " << newId << std::endl;
                     cfg.lastKnownId = newId;
+                    moved.push_back(found);
                 }
             }
         }
     }
+    if (!moved.empty()) publishBindings(std::move(set));
+    return moved;
 }
 
 // --- UTILS ---
@@ -102,146 +652,2373 @@ std::string getFullConfigPath() {
     return dir + "/volmix.conf";
 }
 
-void loadConfig(const std::string& path) {
-    std::lock_guard<std::mutex> lock(dataMutex);
-    layeredMapping.clear();
-    std::ifstream f_in(path);
-    if (!f_in.is_open()) return;
+// "taper <master|1-7> <cubic|linear|db>" picks the curve for one fader on all
+// layers. fader comes back as 0 for the master.
+bool parseTaperLine(std::istringstream& fields, int& fader, Taper& taper) {
+    std::string keyword, which, curve, extra;
+    if (!(fields >> keyword >> which >> curve) || keyword != "taper" || (fields >> extra)) return false;
+    if (which == "master") fader = 0;
+    else if (which.size() == 1 && which[0] >= '1' && which[0] <= '0' + NUM_FADERS) fader = which[0] - '0';
+    else return false;
+    return parseTaper(curve, taper);
+}
+
+// "controller <name> <match>" starts the section for the controllers whose
+// /dev/serial/by-id name contains match; everything up to the next such line
+// belongs to it.
+bool parseControllerLine(std::istringstream& fields, std::string& name, std::string& match) {
+    std::string keyword, extra;
+    return (fields >> keyword >> name >> match) && keyword == "controller" && !(fields >> extra);
+}
+
+// "group <name> <id> <alias>" adds one target to a group. A binding whose id
+// is @name drives every member, and the whole group moves in one batch. Groups
+// belong to the file, not a section, and may be listed after their bindings.
+using TargetGroups = std::map<std::string, std::vector<std::pair<std::string, std::string>>>;
+
+bool parseGroupLine(std::istringstream& fields, std::string& name, std::string& id, std::string& alias) {
+    std::string keyword, extra;
+    return (fields >> keyword >> name >> id >> alias) && keyword == "group" && !(fields >> extra);
+}
+
+bool isGroupRef(const std::string& id) {
+    return id.size() > 1 && id[0] == '@' && id != "@DEFAULT_AUDIO_SINK@";
+}
+
+TargetGroups collectGroups(const std::vector<std::string>& lines) {
+    TargetGroups groups;
+    for (auto const& line : lines) {
+        std::istringstream fields(line);
+        std::string name, id, alias;
+        if (parseGroupLine(fields, name, id, alias)) groups[name].emplace_back(id, alias);
+    }
+    return groups;
+}
+
+// Resolves a binding that was not in the previous config.
+FaderConfig resolveBinding(const std::string& cid, const std::string& calias) {
+    FaderConfig cfg{cid, calias, cid, calias};
+    // Check if cid is numeric and not the default sink string
+    bool isNumeric = !cid.empty() && std::all_of(cid.begin(), cid.end(), ::isdigit);
+    if (cid == "@DEFAULT_AUDIO_SINK@" || !isNumeric) return cfg;
+
+    std::string foundName = nodeRegistry.displayName(static_cast<uint32_t>(std::strtoul(cid.c_str(), nullptr, 10)));
+    if (!foundName.empty()) {
+        cfg.resolvedName = foundName;
+    } else if (uint32_t found = nodeRegistry.findByName(calias)) {
+        // The saved ID is stale; follow the alias to wherever the node is now.
+        cfg.lastKnownId = std::to_string(found);
+    }
+    return cfg;
+}
 
-    int cl, cf; std::string cid, calias;
-    while (f_in >> cl >> cf >> cid >> calias) {
-        std::string resolvedName = calias;
-        // Check if cid is numeric and not the default sink string
-        bool isNumeric = !cid.empty() && std::all_of(cid.begin(), cid.end(), ::isdigit);
-        
-        if (cid != "@DEFAULT_AUDIO_SINK@" && isNumeric) {
-            std::string foundName = getPwInfo(cid, true);
-            if (!foundName.empty()) {
-                resolvedName = foundName;
+// Parses the config into a fresh table and publishes it in one swap. Lines
+// that were already there keep their resolved state, so only new or edited
+// bindings cost a lookup. Returns the targets of those bindings.
+std::vector<TargetId> applyBindings(std::istream& in, const std::string& source) {
+    ScopedTimer timer(stats.refresh);
+    stats.refreshes.fetch_add(1, std::memory_order_relaxed);
+    std::vector<TargetId> added;
+    using Key = std::tuple<std::string, int, int, std::string, std::string>;
+    std::map<Key, std::vector<const FaderConfig*>> previous;
+    for (auto const& section : bindings) {
+        for (auto const& [layer, faders] : section.layers) {
+            for (auto const& [faderIdx, cfg] : faders) {
+                previous[Key{section.name, layer, faderIdx, cfg.configuredId, cfg.alias}].push_back(&cfg);
             }
         }
-        layeredMapping[cl].insert({cf, {cid, resolvedName}});
     }
-    std::cout << "[INFO] Config loaded from " << path << std::endl;
-}
 
-void runWpctl(std::string targetId, int percent) {
-    if (targetId.empty() || targetId == "---" || targetId == "0") return;
-    
-    // Validate target (Must be @DEFAULT or a numeric ID > 10)
-    if (targetId != "@DEFAULT_AUDIO_SINK@") {
-        if (!std::all_of(targetId.begin(), targetId.end(), ::isdigit) || targetId.length() < 2) return;
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) lines.push_back(std::move(line));
+    TargetGroups groups = collectGroups(lines);
+
+    BindingSet set(1);
+    ControllerBindings* section = &set[0];
+    size_t kept = 0, total = 0;
+    for (auto const& line : lines) {
+        std::istringstream fields(line);
+        std::string name, match;
+        if (parseControllerLine(fields, name, match)) {
+            if (set.size() < MAX_CONTROLLERS) {
+                set.emplace_back();
+                section = &set.back();
+                section->name = name;
+                section->match = match;
+            } else {
+                std::cout << "[WARN] Too many controller sections, ignoring '" << name << "'" << std::endl;
+                section = nullptr;
+            }
+            continue;
+        }
+        if (!section) continue;
+        fields.clear();
+        fields.seekg(0);
+        int fader; Taper taper;
+        if (parseTaperLine(fields, fader, taper)) {
+            section->tapers[fader] = taper;
+            continue;
+        }
+        fields.clear();
+        fields.seekg(0);
+        int cl, cf; std::string cid, calias;
+        if (!(fields >> cl >> cf >> cid >> calias)) continue;
+        // A group expands into one binding per member, each resolved and
+        // diffed like any other line.
+        std::vector<std::pair<std::string, std::string>> members{{cid, calias}};
+        if (isGroupRef(cid)) {
+            auto group = groups.find(cid.substr(1));
+            if (group == groups.end()) {
+                std::cout << "[WARN] Unknown group '" << cid << "' on layer " << cl << " fader " << cf << std::endl;
+                continue;
+            }
+            members = group->second;
+        }
+        for (auto const& [id, alias] : members) {
+            total++;
+            auto it = previous.find(Key{section->name, cl, cf, id, alias});
+            if (it != previous.end() && !it->second.empty()) {
+                section->layers[cl].insert({cf, *it->second.back()});
+                it->second.pop_back();
+                kept++;
+                continue;
+            }
+            FaderConfig cfg = resolveBinding(id, alias);
+            TargetId target;
+            if (parseTarget(cfg.lastKnownId, target)) added.push_back(target);
+            section->layers[cl].insert({cf, std::move(cfg)});
+        }
+    }
+    size_t removed = 0;
+    for (auto const& [key, left] : previous) removed += left.size();
+
+    // A new taper changes what the fader's current position means. Sections
+    // are matched up by name.
+    for (auto const& now : set) {
+        FaderTapers before;
+        before.fill(Taper::Cubic);
+        for (auto const& old : bindings) {
+            if (old.name == now.name) { before = old.tapers; break; }
+        }
+        for (int fader = 0; fader <= NUM_FADERS; fader++) {
+            if (now.tapers[fader] == before[fader]) continue;
+            if (fader == 0) added.push_back(DEFAULT_SINK_TARGET);
+            for (auto const& [layer, faders] : now.layers) {
+                auto range = faders.equal_range(fader);
+                for (auto b = range.first; b != range.second; ++b) {
+                    TargetId target;
+                    if (parseTarget(b->second.lastKnownId, target)) added.push_back(target);
+                }
+            }
+        }
     }
 
-    double vol = percent / 100.0;
-    std::stringstream cmd;
-    cmd << "wpctl set-volume " << targetId << " " << std::fixed << std::setprecision(2) << vol << " && ";
-    cmd << "wpctl set-mute " << targetId << " " << (percent == 0 ? "1" : "0");
-    system((cmd.str() + " > /dev/null 2>&1 &").c_str());
+    size_t sections = set.size() - 1;
+    publishBindings(std::move(set));
+    std::cout << "[INFO] Config loaded from " << source << " (" << total << " bindings";
+    if (sections) std::cout << " in " << sections + 1 << " sections";
+    std::cout << ", " << added.size() << " new, " << removed << " removed, " << kept << " unchanged)" << std::endl;
+    return added;
 }
 
-// --- SERIAL THREAD ---
+// The config text last applied, from the file or the control socket. A
+// client's change is written to the file and applied at once, so the
+// watcher's reload that follows finds nothing new and is skipped.
+std::string appliedConfig;
+
+std::vector<TargetId> loadConfig(const std::string& path) {
+    std::ifstream f_in(path);
+    if (!f_in.is_open()) return {};
+    std::string text{std::istreambuf_iterator<char>(f_in), std::istreambuf_iterator<char>()};
+    if (text == appliedConfig) return {};
+    appliedConfig = text;
+    std::istringstream in(text);
+    return applyBindings(in, path);
+}
 
-void serialThread() {
-    while (true) {
-        int fd = open(SERIAL_PORT, O_RDONLY | O_NOCTTY);
-        if (fd < 0) { 
-            isSerialAlive = false; 
-            std::this_thread::sleep_for(std::chrono::seconds(2)); 
-            continue; 
+// Stricter than loadConfig, which skips lines it cannot parse: a binding
+// change from a client is applied either completely or not at all. Blank
+// lines and '#' comments are allowed; volmixgui.py sorts lines by the same
+// grammar.
+bool validateBindings(const std::string& text, std::string& error) {
+    std::istringstream in(text);
+    int lineNo = 0;
+    std::vector<std::string> sections;
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(in, line);) lines.push_back(std::move(line));
+    TargetGroups groups = collectGroups(lines);
+    for (auto const& line : lines) {
+        lineNo++;
+        size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') continue;
+        // Quote the line so the client can point at it.
+        std::string at = "line " + std::to_string(lineNo) + " '" + line.substr(first, line.find_last_not_of(" \t\r") + 1 - first) + "': ";
+        std::istringstream fields(line);
+        int layer, fader; std::string id, alias, extra;
+        Taper taper;
+        if (line.compare(0, 11, "controller ") == 0) {
+            std::string name, match;
+            if (!parseControllerLine(fields, name, match)) {
+                error = at + "expected 'controller name match'";
+            } else if (std::find(sections.begin(), sections.end(), name) != sections.end()) {
+                error = at + "duplicate controller '" + name + "'";
+            } else if (sections.size() + 1 >= MAX_CONTROLLERS) {
+                error = at + "more than " + std::to_string(MAX_CONTROLLERS - 1) + " controllers";
+            } else {
+                sections.push_back(name);
+                continue;
+            }
+            return false;
+        }
+        if (line.compare(0, 6, "taper ") == 0) {
+            if (parseTaperLine(fields, fader, taper)) continue;
+            error = at + "expected 'taper master|1-7 cubic|linear|db'";
+            return false;
         }
+        if (line.compare(0, 6, "group ") == 0) {
+            std::string name; TargetId target;
+            if (!parseGroupLine(fields, name, id, alias)) {
+                error = at + "expected 'group name id alias'";
+            } else if (!parseTarget(id, target)) {
+                error = at + "bad target '" + id + "'";
+            } else {
+                continue;
+            }
+            return false;
+        }
+        TargetId target;
+        if (!(fields >> layer >> fader >> id >> alias) || (fields >> extra)) {
+            error = at + "expected 'layer fader id alias'";
+        } else if (layer < 0 || fader < 1 || fader > NUM_FADERS) {
+            error = at + "layer/fader out of range";
+        } else if (isGroupRef(id) && !groups.count(id.substr(1))) {
+            error = at + "unknown group '" + id + "'";
+        } else if (!isGroupRef(id) && !parseTarget(id, target)) {
+            error = at + "bad target '" + id + "'";
+        } else {
+            continue;
+        }
+        return false;
+    }
+    return true;
+}
 
-        struct termios tty;
-        tcgetattr(fd, &tty);
-        cfsetispeed(&tty, BAUD_RATE); 
-        cfsetospeed(&tty, BAUD_RATE);
-        tty.c_cflag |= (CLOCAL | CREAD | CS8);
-        tty.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
-        tcsetattr(fd, TCSANOW, &tty);
+// Same temp-file-and-rename as the GUI, so readers never see half a file.
+bool writeFileAtomic(const std::string& path, const std::string& text) {
+    std::string tmp = path + ".tmp" + std::to_string(getpid());
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    bool ok = write(fd, text.data(), text.size()) == static_cast<ssize_t>(text.size()) && fsync(fd) == 0;
+    close(fd);
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
 
-        isSerialAlive = true;
-        std::vector<int> lastVals(10, -1);
-        std::string buffer; char c;
-
-        while (read(fd, &c, 1) > 0) {
-            if (c == '\n') {
-                if (buffer.find("DATA") != std::string::npos) {
-                    std::vector<int> vals;
-                    std::stringstream ss(buffer); std::string item;
-                    while (std::getline(ss, item, ',')) {
-                        if (item == "DATA") continue;
-                        try { vals.push_back(std::stoi(item)); } catch (...) {}
-                    }
-                    if (vals.size() >= 9) {
-                        activeLayer = vals[0];
-                        // Fader 1
-                        if (std::abs(vals[1] - lastVals[1]) > THRESHOLD) {
-                            int pct = std::clamp((vals[1] * 100) / 1014, 0, 100);
-                            currentPercents[1] = pct;
-                            runWpctl("@DEFAULT_AUDIO_SINK@", pct);
-                            lastVals[1] = vals[1];
-                        }
-                        // Faders 2-8
-                        for (int i = 1; i <= 7; i++) {
-                            if (std::abs(vals[i+1] - lastVals[i+1]) > THRESHOLD) {
-                                std::lock_guard<std::mutex> lock(dataMutex);
-                                int pct = std::clamp((vals[i+1] * 100) / 1014, 0, 100);
-                                currentPercents[i+1] = pct;
-                                auto range = layeredMapping[activeLayer].equal_range(i);
-                                for (auto it = range.first; it != range.second; ++it) {
-                                    runWpctl(it->second.lastKnownId, pct);
-                                }
-                                lastVals[i+1] = vals[i+1];
-                            }
-                        }
-                    }
-                }
-                buffer.clear();
-            } else if (c != '\r') buffer += c;
+// --- EVENT LOOP ---
+
+// One epoll loop on the main thread serves the controllers, device hotplug,
+// the config watcher, the control socket, signals and wakeups from the
+// PipeWire thread. Nothing polls: with no input and no graph changes the
+// backend stays asleep in epoll_wait. Nothing blocks either: wpctl and file
+// writes go to LoopWorker.
+class EventLoop {
+public:
+    using Handler = std::function<void(uint32_t events)>;
+
+    bool start() {
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+        return epollFd >= 0;
+    }
+
+    // fd must be non-blocking: a handler can see an event that was meant for
+    // an earlier fd with the same number.
+    bool add(int fd, uint32_t events, Handler handler) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev) < 0) return false;
+        handlers[fd] = std::make_shared<Handler>(std::move(handler));
+        return true;
+    }
+
+    void modify(int fd, uint32_t events) {
+        epoll_event ev{};
+        ev.events = events;
+        ev.data.fd = fd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &ev);
+    }
+
+    // Before closing fd.
+    void remove(int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        handlers.erase(fd);
+    }
+
+    void run() {
+        epoll_event events[32];
+        while (true) {
+            int n = epoll_wait(epollFd, events, 32, -1);
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0) break;
+            for (int i = 0; i < n; i++) {
+                auto it = handlers.find(events[i].data.fd);
+                if (it == handlers.end()) continue;
+                // Keep the handler alive in case it removes itself.
+                std::shared_ptr<Handler> handler = it->second;
+                (*handler)(events[i].events);
+            }
         }
+        std::cout << "[ERROR] Event loop stopped: " << std::strerror(errno) << std::endl;
+    }
+
+private:
+    int epollFd = -1;
+    std::unordered_map<int, std::shared_ptr<Handler>> handlers;
+};
+
+EventLoop eventLoop;
+
+// Deadlines are rounded up to a whole TIMER_GRID, so timers that come due
+// around the same time share one wakeup.
+constexpr std::chrono::seconds TIMER_GRID{1};
+
+// A timerfd on the loop, for the few things that still have to happen on a
+// schedule. An idle backend in the default setup has none armed.
+class LoopTimer {
+public:
+    ~LoopTimer() {
+        if (fd < 0) return;
+        loop->remove(fd);
         close(fd);
     }
-}
 
-// --- MAIN LOOP ---
+    bool start(EventLoop& eventLoop, std::function<void()> onExpire) {
+        loop = &eventLoop;
+        fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        if (fd < 0) return false;
+        return loop->add(fd, EPOLLIN, [this, onExpire = std::move(onExpire)](uint32_t) {
+            uint64_t expirations;
+            if (read(fd, &expirations, sizeof(expirations)) == sizeof(expirations)) onExpire();
+        });
+    }
 
-int main() {
-    std::string configPath = getFullConfigPath();
-    loadConfig(configPath);
+    // Fires at every multiple of interval on the monotonic clock.
+    void every(std::chrono::seconds interval) { arm(interval, interval); }
 
-    std::thread sThread(serialThread);
-    sThread.detach();
+    // Fires once, at least delay from now. Re-arming moves it.
+    void once(std::chrono::seconds delay) { arm(delay, std::chrono::seconds::zero()); }
 
-    auto lastRefresh = std::chrono::steady_clock::now();
-    auto lastEnforce = std::chrono::steady_clock::now();
-    time_t lastMTime = 0;
+    void stop() {
+        itimerspec spec{};
+        timerfd_settime(fd, 0, &spec, nullptr);
+    }
 
-    while (true) {
-        auto now = std::chrono::steady_clock::now();
+    // Fires once at exactly when, off the grid; for rate limits.
+    void at(std::chrono::steady_clock::time_point when) {
+        // steady_clock is CLOCK_MONOTONIC.
+        int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count();
+        itimerspec spec{};
+        spec.it_value.tv_sec = static_cast<time_t>(ns / 1000000000LL);
+        spec.it_value.tv_nsec = static_cast<long>(std::max<int64_t>(ns % 1000000000LL, 1)); // zero would disarm
+        timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+
+private:
+    void arm(std::chrono::seconds delay, std::chrono::seconds interval) {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int64_t step = std::chrono::nanoseconds(interval.count() ? interval : TIMER_GRID).count();
+        int64_t at = now.tv_sec * 1000000000LL + now.tv_nsec + std::chrono::nanoseconds(delay).count();
+        at = (at + step - 1) / step * step;
+        itimerspec spec{};
+        spec.it_value.tv_sec = static_cast<time_t>(at / 1000000000LL);
+        spec.it_value.tv_nsec = static_cast<long>(at % 1000000000LL);
+        spec.it_interval.tv_sec = static_cast<time_t>(interval.count());
+        timerfd_settime(fd, TFD_TIMER_ABSTIME, &spec, nullptr);
+    }
+
+    EventLoop* loop = nullptr;
+    int fd = -1;
+};
+
+// One background thread for the jobs that would stall the loop: running
+// `wpctl status` and writing files with fsync. Jobs run one at a time in the
+// order posted. A job may return a callback, which then runs on the loop.
+class LoopWorker {
+public:
+    using Done = std::function<void()>;
+    using Job = std::function<Done()>;
+
+    bool start(EventLoop& eventLoop) {
+        doneEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (doneEventFd < 0) return false;
+        if (!eventLoop.add(doneEventFd, EPOLLIN, [this](uint32_t) { runDone(); })) return false;
+        std::thread(&LoopWorker::worker, this).detach();
+        return true;
+    }
+
+    void post(Job job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        cv.notify_one();
+    }
 
-        struct stat st;
-        if (stat(configPath.c_str(), &st) == 0) {
-            if (st.st_mtime > lastMTime) {
-                loadConfig(configPath);
-                lastMTime = st.st_mtime;
+private:
+    void worker() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return !jobs.empty(); });
+                job = std::move(jobs.front());
+                jobs.pop_front();
             }
+            Done done = job();
+            if (!done) continue;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                finished.push_back(std::move(done));
+            }
+            uint64_t one = 1;
+            ssize_t ignored = write(doneEventFd, &one, sizeof(one));
+            (void)ignored;
         }
+    }
 
-        if (std::chrono::duration_cast<std::chrono::seconds>(now - lastRefresh).count() >= 3) {
-            refreshDynamicIds();
-            lastRefresh = now;
+    void runDone() {
+        uint64_t count;
+        ssize_t ignored = read(doneEventFd, &count, sizeof(count));
+        (void)ignored;
+        std::deque<Done> ready;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready.swap(finished);
         }
+        for (auto& done : ready) done();
+    }
+
+    int doneEventFd = -1;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Job> jobs;
+    std::deque<Done> finished;
+};
+
+LoopWorker loopWorker;
 
-        if (std::chrono::duration_cast<std::chrono::seconds>(now - lastEnforce).count() >= 4) {
-            std::lock_guard<std::mutex> lock(dataMutex);
-            runWpctl("@DEFAULT_AUDIO_SINK@", currentPercents[1]);
-            for (auto const& [faderIdx, cfg] : layeredMapping[activeLayer]) {
-                runWpctl(cfg.lastKnownId, currentPercents[faderIdx+1]);
+// --- CONFIG WATCHER ---
+
+// Watches the config directory rather than the file: the GUI replaces the file
+// by renaming a temp file over it, which would orphan a watch on the file.
+// Only completed writes count, so a half-written config is never picked up.
+bool startConfigWatcher(EventLoop& loop, const std::string& path, std::function<void()> onChange) {
+    size_t slash = path.rfind('/');
+    std::string dir = slash == std::string::npos ? "." : path.substr(0, slash);
+    std::string file = slash == std::string::npos ? path : path.substr(slash + 1);
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0) return false;
+    if (inotify_add_watch(fd, dir.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        close(fd);
+        return false;
+    }
+
+    bool added = loop.add(fd, EPOLLIN, [fd, file, onChange = std::move(onChange)](uint32_t) {
+        alignas(struct inotify_event) char buf[4096];
+        bool changed = false;
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + n;) {
+                auto* ev = reinterpret_cast<struct inotify_event*>(p);
+                if (ev->len && file == ev->name) changed = true;
+                p += sizeof(struct inotify_event) + ev->len;
             }
-            lastEnforce = now;
         }
+        // One reload for a burst of events.
+        if (changed) onChange();
+    });
+    if (!added) close(fd);
+    return added;
+}
+
+// --- LEVEL METERS ---
+
+// Levels go down to the controller already in pixels of its channel bars
+// (CH_BAR_MAX_H in main.cpp), on a dB scale from -METER_DB_RANGE to 0 dBFS.
+constexpr int METER_STEPS = 90;
+constexpr double METER_DB_RANGE = 60.0;
+// PipeWire's resampler folds the audio down to this many peaks a second, and
+// the controller hears about changes at most this often.
+constexpr int METER_RATE = 25;
+constexpr std::chrono::microseconds METER_INTERVAL{1000000 / METER_RATE};
+// A meter that stops updating (its node went quiet or away) reads as silent
+// after METER_STALE; a lit meter is re-sent every METER_KEEPALIVE so the
+// controller can drop levels from a host that went away.
+constexpr std::chrono::milliseconds METER_STALE{250};
+constexpr std::chrono::seconds METER_KEEPALIVE{1};
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(250));
+uint8_t quantizeMeter(float peak) {
+    if (!(peak > 0.0f)) return 0;
+    double db = 20.0 * std::log10(std::min(peak, 1.0f));
+    int level = static_cast<int>((db + METER_DB_RANGE) * METER_STEPS / METER_DB_RANGE + 0.5);
+    return static_cast<uint8_t>(std::clamp(level, 0, METER_STEPS));
+}
+
+// --- VOLUME BACKENDS ---
+
+using VolumeBatch = std::vector<std::pair<TargetId, Gain>>;
+
+class VolumeBackend {
+public:
+    virtual ~VolumeBackend() = default;
+    virtual bool start() = 0;
+    virtual void setVolume(TargetId target, Gain gain) = 0;
+    // Backends override this when a batch is cheaper than its parts.
+    virtual void setVolumes(const VolumeBatch& batch) {
+        for (const auto& [target, gain] : batch) setVolume(target, gain);
     }
-    return 0;
-}
\ No newline at end of file
+    virtual const char* name() const = 0;
+    // True when the backend keeps nodeRegistry current from graph events.
+    virtual bool watchesRegistry() const { return false; }
+
+    // Called (from the backend's own thread) when a target we set was changed
+    // by someone else. Backends without change events never call it.
+    void setOnExternalChange(std::function<void(TargetId)> callback) {
+        onExternalChange = std::move(callback);
+    }
+
+    // Level meters. A backend that can measure levels keeps a peak meter on
+    // every target of the last set it was given, and calls onMeterChange (from
+    // its own thread) whenever a quantized level moves. Only the main loop
+    // sets targets and reads levels.
+    virtual bool hasMeters() const { return false; }
+    virtual void setMeteredTargets(const std::vector<TargetId>&) {}
+    virtual uint8_t meterLevel(TargetId) const { return 0; }
+
+    void setOnMeterChange(std::function<void()> callback) {
+        onMeterChange = std::move(callback);
+    }
+
+    // Backends with a connection to the audio server. reconnect() makes one
+    // attempt without blocking; onConnectionChange (from the backend's own
+    // thread) reports the connection lost, and back once the graph is in.
+    virtual bool reconnect() { return false; }
+
+    void setOnConnectionChange(std::function<void()> callback) {
+        onConnectionChange = std::move(callback);
+    }
+
+protected:
+    std::function<void(TargetId)> onExternalChange;
+    std::function<void()> onMeterChange;
+    std::function<void()> onConnectionChange;
+};
+
+// Fallback: one shell + two wpctl processes per call. Runs synchronously so
+// the scheduler's ordering guarantee holds.
+class WpctlBackend : public VolumeBackend {
+public:
+    bool start() override { return true; }
+    const char* name() const override { return "wpctl"; }
+
+    void setVolume(TargetId target, Gain gain) override {
+        setVolumes(VolumeBatch{{target, gain}});
+    }
+
+    // One shell for the whole batch.
+    void setVolumes(const VolumeBatch& batch) override {
+        if (batch.empty()) return;
+        std::stringstream cmd;
+        cmd << std::fixed << std::setprecision(4) << "{ ";
+        for (const auto& [target, gain] : batch) {
+            // wpctl takes volumes on its cubic scale.
+            double vol = std::cbrt(static_cast<double>(gain) / GAIN_ONE);
+            std::string targetId = targetName(target);
+            cmd << "wpctl set-volume " << targetId << " " << vol << " && ";
+            cmd << "wpctl set-mute " << targetId << " " << (gain == 0 ? "1" : "0") << "; ";
+        }
+        system((cmd.str() + "} > /dev/null 2>&1").c_str());
+    }
+};
+
+// Stand-in sink for volmix_bench: writes "<steady clock ns> <target> <Q24 gain>"
+// per call to VOLMIX_TRACE_FD (stderr by default) and touches no audio.
+class TraceBackend : public VolumeBackend {
+public:
+    bool start() override {
+        const char* fdEnv = std::getenv("VOLMIX_TRACE_FD");
+        fd = fdEnv ? std::atoi(fdEnv) : 2;
+        return true;
+    }
+    const char* name() const override { return "trace"; }
+    // There is no graph to watch; this just keeps the main loop from polling wpctl.
+    bool watchesRegistry() const override { return true; }
+
+    void setVolume(TargetId target, Gain gain) override {
+        setVolumes(VolumeBatch{{target, gain}});
+    }
+
+    // One line per target, one write per batch.
+    void setVolumes(const VolumeBatch& batch) override {
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        out.clear();
+        for (const auto& [target, gain] : batch) {
+            char line[64];
+            int len = snprintf(line, sizeof(line), "%lld %u %u\n", ns, target, gain);
+            out.append(line, static_cast<size_t>(len));
+        }
+        ssize_t ignored = write(fd, out.data(), out.size());
+        (void)ignored;
+    }
+
+private:
+    int fd = 2;
+    std::string out;
+};
+
+#if VOLMIX_USE_PIPEWIRE
+// Keeps one core connection open and writes channelVolumes/mute straight into
+// the node's Props param. Calls come from the scheduler thread, so every access to
+// PipeWire objects happens under the thread loop lock. While the daemon is
+// away (e.g. restarted) volumes go through wpctl, and the main loop dials
+// again with reconnect().
+class PipeWireBackend : public VolumeBackend {
+public:
+    ~PipeWireBackend() override {
+        if (loop) pw_thread_loop_stop(loop);
+        disconnect();
+        if (context) pw_context_destroy(context);
+        if (loop) pw_thread_loop_destroy(loop);
+    }
+
+    const char* name() const override { return "pipewire"; }
+    bool watchesRegistry() const override { return connected; }
+
+    // Only fails without a usable PipeWire library. A daemon that is not up
+    // yet is dialled again from the main loop's 3 s tick like a lost one, and
+    // wpctl carries the volumes until then.
+    bool start() override {
+        pw_init(nullptr, nullptr);
+        loop = pw_thread_loop_new("volmix-pw", nullptr);
+        if (!loop) return false;
+        context = pw_context_new(pw_thread_loop_get_loop(loop), nullptr, 0);
+        if (!context || pw_thread_loop_start(loop) < 0) return false;
+
+        pw_thread_loop_lock(loop);
+        // Wait for the initial batch of globals so the first fader move
+        // already finds its node.
+        if (connect()) {
+            while (!synced && connected) pw_thread_loop_wait(loop);
+        }
+        pw_thread_loop_unlock(loop);
+        if (!connected) std::cout << "[WARN] PipeWire not reachable, using wpctl until it is" << std::endl;
+        return true;
+    }
+
+    // From the main loop, which also owns the meters torn down here. The old
+    // nodes leave the registry; the new ones arrive as registry events.
+    bool reconnect() override {
+        if (connected) return true;
+        pw_thread_loop_lock(loop);
+        disconnect();
+        bool ok = connect();
+        if (ok) nodeRegistry.replaceAll({});
+        pw_thread_loop_unlock(loop);
+        return ok;
+    }
+
+    void setVolume(TargetId target, Gain volume) override {
+        setVolumes(VolumeBatch{{target, volume}});
+    }
+
+    bool hasMeters() const override { return connected; }
+
+    // Targets that dropped out, or whose node went away or changed (the
+    // default sink), lose their stream; ones whose node has not shown up yet
+    // are tried again on the next call.
+    void setMeteredTargets(const std::vector<TargetId>& targets) override {
+        if (!connected) return;
+        pw_thread_loop_lock(loop);
+        for (auto it = meters.begin(); it != meters.end();) {
+            Node* node = findTarget(it->first);
+            bool wanted = std::find(targets.begin(), targets.end(), it->first) != targets.end();
+            if (wanted && node && node->id == it->second->node) { ++it; continue; }
+            destroyMeter(*it->second);
+            it = meters.erase(it);
+        }
+        for (TargetId target : targets) {
+            if (meters.count(target)) continue;
+            Node* node = findTarget(target);
+            if (!node) continue;
+            if (auto meter = createMeter(*node)) meters[target] = std::move(meter);
+        }
+        pw_thread_loop_unlock(loop);
+    }
+
+    uint8_t meterLevel(TargetId target) const override {
+        auto it = meters.find(target);
+        if (it == meters.end()) return 0;
+        const Meter& meter = *it->second;
+        auto age = std::chrono::steady_clock::now().time_since_epoch().count() - meter.updated.load(std::memory_order_relaxed);
+        if (age > std::chrono::steady_clock::duration(METER_STALE).count()) return 0;
+        return meter.level.load(std::memory_order_relaxed);
+    }
+
+    // One loop lock for the whole batch; the params go out together.
+    void setVolumes(const VolumeBatch& batch) override {
+        if (!connected) { fallback.setVolumes(batch); return; }
+
+        pw_thread_loop_lock(loop);
+        for (const auto& [target, volume] : batch) {
+            float gain = static_cast<float>(volume) / GAIN_ONE;
+            bool mute = (volume == 0);
+            Node* node = findTarget(target);
+            if (!node) continue;
+            if (node->channels > 0) {
+                pushVolume(*node, gain, mute);
+            } else {
+                // Props not enumerated yet; applied from onNodeParam.
+                node->pending = true;
+                node->pendingGain = gain;
+                node->pendingMute = mute;
+            }
+        }
+        pw_thread_loop_unlock(loop);
+    }
+
+private:
+    struct Node {
+        PipeWireBackend* owner = nullptr;
+        uint32_t id = 0;
+        std::string name;
+        std::string serial;
+        bool sink = false; // metered through its monitor ports
+        pw_proxy* proxy = nullptr;
+        spa_hook listener{};
+        uint32_t channels = 0;
+        bool pending = false;
+        float pendingGain = 0.0f;
+        bool pendingMute = false;
+        // Last values we wrote, to tell our own echoes from outside changes.
+        bool pushed = false;
+        float pushedGain = 0.0f;
+        bool pushedMute = false;
+    };
+
+    // A passive capture stream on one node, so it never keeps a device awake.
+    // With resample.peaks the adapter hands us METER_RATE mono peaks a second
+    // instead of the audio, which keeps the cost per node tiny.
+    struct Meter {
+        uint32_t node = 0;
+        pw_stream* stream = nullptr;
+        spa_hook listener{};
+        std::function<void()>* onChange = nullptr;
+        std::atomic<uint8_t> level{0};
+        std::atomic<std::chrono::steady_clock::rep> updated{0};
+    };
+
+    std::unique_ptr<Meter> createMeter(const Node& node) {
+        pw_properties* props = pw_properties_new(
+            PW_KEY_MEDIA_TYPE, "Audio",
+            PW_KEY_MEDIA_CATEGORY, "Monitor",
+            PW_KEY_NODE_NAME, "volmix-meter",
+            PW_KEY_NODE_PASSIVE, "true",
+            PW_KEY_STREAM_MONITOR, "true",
+            PW_KEY_RESAMPLE_PEAKS, "true",
+            nullptr);
+        if (!props) return nullptr;
+        if (node.sink) pw_properties_set(props, PW_KEY_STREAM_CAPTURE_SINK, "true");
+#ifdef PW_KEY_TARGET_OBJECT
+        pw_properties_set(props, PW_KEY_TARGET_OBJECT, node.serial.empty() ? node.name.c_str() : node.serial.c_str());
+        uint32_t connectTo = PW_ID_ANY;
+#else
+        uint32_t connectTo = node.id;
+#endif
+
+        auto meter = std::make_unique<Meter>();
+        meter->node = node.id;
+        meter->onChange = &onMeterChange;
+        meter->stream = pw_stream_new(core, "volmix-meter", props);
+        if (!meter->stream) return nullptr;
+        static const pw_stream_events meterEvents = makeMeterEvents();
+        pw_stream_add_listener(meter->stream, &meter->listener, &meterEvents, meter.get());
+
+        uint8_t buffer[256];
+        spa_pod_builder b = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+        spa_audio_info_raw info{};
+        info.format = SPA_AUDIO_FORMAT_F32;
+        info.channels = 1;
+        info.rate = METER_RATE;
+        const spa_pod* params[] = { spa_format_audio_raw_build(&b, SPA_PARAM_EnumFormat, &info) };
+        auto flags = static_cast<pw_stream_flags>(PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS);
+        if (pw_stream_connect(meter->stream, PW_DIRECTION_INPUT, connectTo, flags, params, 1) < 0) {
+            destroyMeter(*meter);
+            return nullptr;
+        }
+        return meter;
+    }
+
+    void destroyMeter(Meter& meter) {
+        spa_hook_remove(&meter.listener);
+        pw_stream_destroy(meter.stream);
+    }
+
+    static void onMeterProcess(void* data) {
+        auto* meter = static_cast<Meter*>(data);
+        pw_buffer* buf = pw_stream_dequeue_buffer(meter->stream);
+        if (!buf) return;
+        const spa_data& d = buf->buffer->datas[0];
+        uint32_t offset = d.chunk ? std::min(d.chunk->offset, d.maxsize) : 0;
+        uint32_t size = d.chunk ? std::min(d.chunk->size, d.maxsize - offset) : 0;
+        const auto* samples = static_cast<const float*>(SPA_PTROFF(d.data, offset, void));
+        uint32_t n = d.data ? size / sizeof(float) : 0;
+        float peak = 0.0f;
+        for (uint32_t i = 0; i < n; i++) peak = std::max(peak, std::abs(samples[i]));
+        pw_stream_queue_buffer(meter->stream, buf);
+        if (n == 0) return;
+
+        meter->updated.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        uint8_t level = quantizeMeter(peak);
+        if (meter->level.exchange(level, std::memory_order_relaxed) != level && *meter->onChange) (*meter->onChange)();
+    }
+
+    static bool isAudioClass(const char* mediaClass) {
+        if (!mediaClass) return false;
+        std::string mc(mediaClass);
+        return mc == "Audio/Sink" || mc == "Audio/Source" || mc == "Audio/Duplex" ||
+               mc == "Stream/Output/Audio" || mc == "Stream/Input/Audio";
+    }
+
+    static pw_core_events makeCoreEvents() {
+        pw_core_events ev{};
+        ev.version = PW_VERSION_CORE_EVENTS;
+        ev.done = onCoreDone;
+        ev.error = onCoreError;
+        return ev;
+    }
+
+    static pw_registry_events makeRegistryEvents() {
+        pw_registry_events ev{};
+        ev.version = PW_VERSION_REGISTRY_EVENTS;
+        ev.global = onGlobal;
+        ev.global_remove = onGlobalRemove;
+        return ev;
+    }
+
+    static pw_node_events makeNodeEvents() {
+        pw_node_events ev{};
+        ev.version = PW_VERSION_NODE_EVENTS;
+        ev.param = onNodeParam;
+        return ev;
+    }
+
+    static pw_stream_events makeMeterEvents() {
+        pw_stream_events ev{};
+        ev.version = PW_VERSION_STREAM_EVENTS;
+        ev.process = onMeterProcess;
+        return ev;
+    }
+
+    static pw_metadata_events makeMetadataEvents() {
+        pw_metadata_events ev{};
+        ev.version = PW_VERSION_METADATA_EVENTS;
+        ev.property = onMetadataProperty;
+        return ev;
+    }
+
+    // Under the loop lock. connected holds from here until the daemon goes
+    // away; synced once the globals that existed at connect time are in.
+    bool connect() {
+        core = pw_context_connect(context, nullptr, 0);
+        if (!core) return false;
+        static const pw_core_events coreEvents = makeCoreEvents();
+        static const pw_registry_events registryEvents = makeRegistryEvents();
+        pw_core_add_listener(core, &coreListener, &coreEvents, this);
+        registry = pw_core_get_registry(core, PW_VERSION_REGISTRY, 0);
+        pw_registry_add_listener(registry, &registryListener, &registryEvents, this);
+        synced = false;
+        syncSeq = pw_core_sync(core, PW_ID_CORE, 0);
+        connected = true;
+        return true;
+    }
+
+    // Under the loop lock (or with the loop stopped). Proxies go before the
+    // core, which would otherwise free them underneath us.
+    void disconnect() {
+        connected = false;
+        for (auto& [target, meter] : meters) destroyMeter(*meter);
+        meters.clear();
+        for (auto& [id, node] : nodes) destroyNode(*node);
+        nodes.clear();
+        if (metadata) { spa_hook_remove(&metadataListener); pw_proxy_destroy(metadata); metadata = nullptr; }
+        if (registry) { spa_hook_remove(&registryListener); pw_proxy_destroy(reinterpret_cast<pw_proxy*>(registry)); registry = nullptr; }
+        if (core) { spa_hook_remove(&coreListener); pw_core_disconnect(core); core = nullptr; }
+        defaultSinkName.clear();
+    }
+
+    static void onCoreDone(void* data, uint32_t id, int seq) {
+        auto* self = static_cast<PipeWireBackend*>(data);
+        if (id == PW_ID_CORE && seq == self->syncSeq) {
+            self->synced = true;
+            pw_thread_loop_signal(self->loop, false);
+            if (self->onConnectionChange) self->onConnectionChange();
+        }
+    }
+
+    static void onCoreError(void* data, uint32_t id, int, int res, const char* message) {
+        auto* self = static_cast<PipeWireBackend*>(data);
+        std::cout << "[WARN] PipeWire error on " << id << ": " << (message ? message : "") << std::endl;
+        if (id == PW_ID_CORE && res == -EPIPE) {
+            bool was = self->connected.exchange(false);
+            pw_thread_loop_signal(self->loop, false);
+            if (was && self->onConnectionChange) self->onConnectionChange();
+        }
+    }
+
+    static void onGlobal(void* data, uint32_t id, uint32_t, const char* type, uint32_t, const spa_dict* props) {
+        auto* self = static_cast<PipeWireBackend*>(data);
+        if (!props) return;
+
+        if (std::string(type) == PW_TYPE_INTERFACE_Metadata) {
+            const char* metaName = spa_dict_lookup(props, PW_KEY_METADATA_NAME);
+            if (self->metadata || !metaName || std::string(metaName) != "default") return;
+            static const pw_metadata_events metadataEvents = makeMetadataEvents();
+            self->metadata = static_cast<pw_proxy*>(pw_registry_bind(self->registry, id, PW_TYPE_INTERFACE_Metadata, PW_VERSION_METADATA, 0));
+            if (self->metadata) {
+                pw_metadata_add_listener(reinterpret_cast<pw_metadata*>(self->metadata), &self->metadataListener, &metadataEvents, self);
+            }
+            return;
+        }
+
+        if (std::string(type) != PW_TYPE_INTERFACE_Node) return;
+        if (!isAudioClass(spa_dict_lookup(props, PW_KEY_MEDIA_CLASS))) return;
+
+        auto lookup = [props](const char* key) {
+            const char* value = spa_dict_lookup(props, key);
+            return std::string(value ? value : "");
+        };
+        NodeInfo info;
+        info.id = id;
+        info.name = lookup(PW_KEY_NODE_NAME);
+        info.mediaClass = lookup(PW_KEY_MEDIA_CLASS);
+        info.appName = lookup(PW_KEY_APP_NAME);
+        if (info.mediaClass.rfind("Stream/", 0) == 0) {
+            info.displayName = !info.appName.empty() ? info.appName : info.name;
+        } else {
+            info.displayName = lookup(PW_KEY_NODE_DESCRIPTION);
+            if (info.displayName.empty()) info.displayName = lookup(PW_KEY_NODE_NICK);
+            if (info.displayName.empty()) info.displayName = info.name;
+        }
+
+        auto node = std::make_unique<Node>();
+        node->owner = self;
+        node->id = id;
+        node->name = info.name;
+        node->sink = info.mediaClass == "Audio/Sink";
+#ifdef PW_KEY_OBJECT_SERIAL
+        node->serial = lookup(PW_KEY_OBJECT_SERIAL);
+#endif
+        node->proxy = static_cast<pw_proxy*>(pw_registry_bind(self->registry, id, PW_TYPE_INTERFACE_Node, PW_VERSION_NODE, 0));
+        if (!node->proxy) return;
+
+        static const pw_node_events nodeEvents = makeNodeEvents();
+        pw_node_add_listener(reinterpret_cast<pw_node*>(node->proxy), &node->listener, &nodeEvents, node.get());
+        uint32_t ids[] = { SPA_PARAM_Props };
+        pw_node_subscribe_params(reinterpret_cast<pw_node*>(node->proxy), ids, 1);
+
+        self->nodes[id] = std::move(node);
+        nodeRegistry.add(info);
+    }
+
+    static void onGlobalRemove(void* data, uint32_t id) {
+        auto* self = static_cast<PipeWireBackend*>(data);
+        auto it = self->nodes.find(id);
+        if (it == self->nodes.end()) return;
+        self->destroyNode(*it->second);
+        self->nodes.erase(it);
+        nodeRegistry.remove(id);
+    }
+
+    static void onNodeParam(void* data, int, uint32_t id, uint32_t, uint32_t, const spa_pod* param) {
+        auto* node = static_cast<Node*>(data);
+        if (id != SPA_PARAM_Props || !param || !spa_pod_is_object_type(param, SPA_TYPE_OBJECT_Props)) return;
+
+        const auto* obj = reinterpret_cast<const spa_pod_object*>(param);
+        const spa_pod_prop* prop;
+        float gain = -1.0f;
+        bool mute = false, haveMute = false;
+        SPA_POD_OBJECT_FOREACH(obj, prop) {
+            if (prop->key == SPA_PROP_channelVolumes) {
+                float vols[SPA_AUDIO_MAX_CHANNELS];
+                uint32_t n = spa_pod_copy_array(&prop->value, SPA_TYPE_Float, vols, SPA_AUDIO_MAX_CHANNELS);
+                if (n > 0) {
+                    node->channels = n;
+                    gain = *std::max_element(vols, vols + n);
+                }
+            } else if (prop->key == SPA_PROP_mute) {
+                haveMute = spa_pod_get_bool(&prop->value, &mute) >= 0;
+            }
+        }
+
+        if (node->pending && node->channels > 0) {
+            node->pending = false;
+            node->owner->pushVolume(*node, node->pendingGain, node->pendingMute);
+            return;
+        }
+
+        bool drifted = (gain >= 0.0f && std::abs(gain - node->pushedGain) > 1e-4f) ||
+                       (haveMute && mute != node->pushedMute);
+        if (node->pushed && drifted && node->owner->onExternalChange) {
+            node->owner->onExternalChange(node->id);
+            if (node->name == node->owner->defaultSinkName) node->owner->onExternalChange(DEFAULT_SINK_TARGET);
+        }
+    }
+
+    static int onMetadataProperty(void* data, uint32_t subject, const char* key, const char*, const char* value) {
+        auto* self = static_cast<PipeWireBackend*>(data);
+        if (subject != PW_ID_CORE) return 0;
+        if (!key) { self->defaultSinkName.clear(); return 0; }
+        if (std::string(key) != "default.audio.sink") return 0;
+
+        // value looks like: { "name": "alsa_output.pci-0000_00_1f.3.analog-stereo" }
+        std::string json = value ? value : "";
+        std::string name;
+        size_t keyPos = json.find("\"name\"");
+        size_t start = keyPos == std::string::npos ? keyPos : json.find('"', json.find(':', keyPos));
+        size_t end = start == std::string::npos ? start : json.find('"', start + 1);
+        if (end != std::string::npos) name = json.substr(start + 1, end - start - 1);
+
+        bool changed = !name.empty() && name != self->defaultSinkName;
+        self->defaultSinkName = name;
+        // The master fader follows the default sink; give the new one its level.
+        if (changed && self->onExternalChange) self->onExternalChange(DEFAULT_SINK_TARGET);
+        return 0;
+    }
+
+    Node* findTarget(TargetId target) {
+        if (target == DEFAULT_SINK_TARGET) {
+            if (defaultSinkName.empty()) return nullptr;
+            for (auto& [id, node] : nodes) {
+                if (node->name == defaultSinkName) return node.get();
+            }
+            return nullptr;
+        }
+        auto it = nodes.find(target);
+        return it == nodes.end() ? nullptr : it->second.get();
+    }
+
+    void pushVolume(Node& node, float gain, bool mute) {
+        uint8_t buffer[1024];
+        spa_pod_builder b = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+        float volumes[SPA_AUDIO_MAX_CHANNELS];
+        uint32_t n = std::min<uint32_t>(node.channels, SPA_AUDIO_MAX_CHANNELS);
+        std::fill_n(volumes, n, gain);
+
+        auto* param = static_cast<spa_pod*>(spa_pod_builder_add_object(&b,
+            SPA_TYPE_OBJECT_Props, SPA_PARAM_Props,
+            SPA_PROP_channelVolumes, SPA_POD_Array(sizeof(float), SPA_TYPE_Float, n, volumes),
+            SPA_PROP_mute, SPA_POD_Bool(mute)));
+        pw_node_set_param(reinterpret_cast<pw_node*>(node.proxy), SPA_PARAM_Props, 0, param);
+        node.pushed = true;
+        node.pushedGain = gain;
+        node.pushedMute = mute;
+    }
+
+    void destroyNode(Node& node) {
+        spa_hook_remove(&node.listener);
+        pw_proxy_destroy(node.proxy);
+    }
+
+    pw_thread_loop* loop = nullptr;
+    pw_context* context = nullptr;
+    pw_core* core = nullptr;
+    pw_registry* registry = nullptr;
+    pw_proxy* metadata = nullptr;
+    spa_hook coreListener{};
+    spa_hook registryListener{};
+    spa_hook metadataListener{};
+    std::map<uint32_t, std::unique_ptr<Node>> nodes;
+    std::map<TargetId, std::unique_ptr<Meter>> meters; // changed by the main loop only
+    std::string defaultSinkName;
+    int syncSeq = 0;
+    bool synced = false;
+    std::atomic<bool> connected{false};
+    WpctlBackend fallback;
+};
+#endif
+
+std::unique_ptr<VolumeBackend> volumeBackend;
+
+void initVolumeBackend() {
+    const char* forced = std::getenv("VOLMIX_BACKEND");
+    std::string wanted = forced ? forced : "";
+    if (wanted == "trace") {
+        volumeBackend = std::make_unique<TraceBackend>();
+        volumeBackend->start();
+    }
+#if VOLMIX_USE_PIPEWIRE
+    if (!volumeBackend && wanted != "wpctl") {
+        auto pw = std::make_unique<PipeWireBackend>();
+        if (pw->start()) {
+            volumeBackend = std::move(pw);
+        } else {
+            std::cout << "[WARN] PipeWire unavailable, falling back to wpctl" << std::endl;
+        }
+    }
+#endif
+    if (!volumeBackend) {
+        volumeBackend = std::make_unique<WpctlBackend>();
+        volumeBackend->start();
+    }
+    std::cout << "[INFO] Volume backend: " << volumeBackend->name() << std::endl;
+}
+
+// --- VOLUME SCHEDULER ---
+
+// Sits between the faders and the backend. Each target has one slot holding
+// only the newest requested value; a single worker drains dirty slots, at most
+// maxRate times per second per target, and waits for each call to finish
+// before the next. A sweep therefore costs a bounded number of backend calls
+// and the last value always lands last.
+class VolumeScheduler {
+public:
+    VolumeScheduler(VolumeBackend& backend, int maxRate)
+        : backend(backend), minInterval(std::chrono::microseconds(1000000 / std::max(maxRate, 1))) {
+        std::thread(&VolumeScheduler::worker, this).detach();
+    }
+
+    void submit(TargetId target, Gain gain) {
+        submit(VolumeBatch{{target, gain}});
+    }
+
+    // All under one lock with one wakeup, so the worker picks the whole batch
+    // up in the same pass.
+    void submit(const VolumeBatch& batch) {
+        if (batch.empty()) return;
+        {
+            ScopedTimer timer(stats.submit);
+            auto now = std::chrono::steady_clock::now();
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto const& [target, gain] : batch) {
+                Slot& slot = slots[target];
+                slot.value = gain;
+                if (slot.dirty) {
+                    stats.commandsCoalesced.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    slot.dirty = true;
+                    slot.since = now;
+                }
+            }
+        }
+        stats.commandsSubmitted.fetch_add(batch.size(), std::memory_order_relaxed);
+        cv.notify_one();
+    }
+
+private:
+    struct Slot {
+        Gain value = 0;
+        bool dirty = false;
+        std::chrono::steady_clock::time_point since{}; // when it became dirty
+        std::chrono::steady_clock::time_point lastSent{};
+    };
+
+    void worker() {
+        VolumeBatch batch;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            auto now = std::chrono::steady_clock::now();
+            auto nextDue = std::chrono::steady_clock::time_point::max();
+            batch.clear();
+            for (auto& [target, slot] : slots) {
+                if (!slot.dirty) continue;
+                auto due = slot.lastSent + minInterval;
+                if (due <= now) {
+                    stats.queued.record(now - slot.since);
+                    batch.emplace_back(target, slot.value);
+                    slot.dirty = false;
+                    slot.lastSent = now;
+                } else {
+                    nextDue = std::min(nextDue, due);
+                }
+            }
+
+            if (batch.empty()) {
+                if (nextDue == std::chrono::steady_clock::time_point::max()) cv.wait(lock);
+                else cv.wait_until(lock, nextDue);
+                continue;
+            }
+
+            lock.unlock();
+            {
+                ScopedTimer timer(stats.apply);
+                backend.setVolumes(batch);
+            }
+            stats.commandsIssued.fetch_add(batch.size(), std::memory_order_relaxed);
+            lock.lock();
+        }
+    }
+
+    VolumeBackend& backend;
+    const std::chrono::microseconds minInterval;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::unordered_map<TargetId, Slot> slots;
+};
+
+std::unique_ptr<VolumeScheduler> volumeScheduler;
+
+void initVolumeScheduler() {
+    const char* rate = std::getenv("VOLMIX_MAX_RATE");
+    int maxRate = rate ? std::atoi(rate) : 0;
+    if (maxRate <= 0) maxRate = 50;
+    volumeScheduler = std::make_unique<VolumeScheduler>(*volumeBackend, maxRate);
+    std::cout << "[INFO] Volume updates limited to " << maxRate << "/s per target" << std::endl;
+}
+
+void setTargetVolume(TargetId target, Gain gain) {
+    volumeScheduler->submit(target, gain);
+}
+
+// --- SERIAL FRAME DECODER ---
+
+// The frame format and FrameDecoder are in volmix_frame.h.
+
+// Replays a captured serial log (e.g. `cat /dev/ttyUSB0 > capture.log`) through
+// the decoder in read()-sized chunks and reports decode throughput.
+int benchParse(const std::string& capturePath) {
+    std::ifstream f_in(capturePath, std::ios::binary);
+    if (!f_in.is_open()) {
+        std::cout << "[ERROR] Cannot open " << capturePath << std::endl;
+        return 1;
+    }
+    std::string capture((std::istreambuf_iterator<char>(f_in)), std::istreambuf_iterator<char>());
+    if (capture.empty()) return 1;
+
+    const size_t CHUNK = 64;
+    FrameDecoder decoder;
+    uint64_t checksum = 0, bytes = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::steady_clock::duration::zero();
+    while (elapsed < std::chrono::seconds(1)) {
+        for (size_t off = 0; off < capture.size(); off += CHUNK) {
+            size_t n = std::min(CHUNK, capture.size() - off);
+            decoder.feed(capture.data() + off, n, [&](const Frame& frame) { checksum += frame.channels[NUM_FADERS - 1]; });
+        }
+        bytes += capture.size();
+        elapsed = std::chrono::steady_clock::now() - start;
+    }
+
+    double secs = std::chrono::duration<double>(elapsed).count();
+    double frames = static_cast<double>(decoder.frameCount());
+    std::cout << std::fixed << std::setprecision(1)
+              << "frames: " << decoder.frameCount() << "  errors: " << decoder.errorCount()
+              << "  corrupt: " << decoder.corruptCount() << "  dropped: " << decoder.droppedCount() << "\n"
+              << "throughput: " << frames / secs << " frames/s, " << bytes / secs / 1e6 << " MB/s\n"
+              << "cost: " << (frames > 0 ? secs * 1e9 / frames : 0.0) << " ns/frame"
+              << "  (checksum " << checksum << ")" << std::endl;
+    return 0;
+}
+
+// --- SERIAL INPUT ---
+
+// What a controller last acted on. The controller stores separate channel
+// values per layer, so they are tracked per layer as well. The master is one
+// physical fader. -1 means nothing yet.
+struct FaderInputs {
+    struct Applied {
+        int raw = -1;
+        int64_t gain = -1;
+    };
+    Applied master;
+    std::map<int, std::array<Applied, NUM_FADERS>> layers;
+    int layer = -1;
+    VolumeBatch batch; // reused for every frame
+
+    // The routing changed under the layers that are not showing; they are
+    // applied in full the next time they come up.
+    void forgetInactiveLayers() {
+        for (auto it = layers.begin(); it != layers.end();) {
+            it = it->first == layer ? std::next(it) : layers.erase(it);
+        }
+    }
+};
+
+// threshold is the raw ADC jitter to ignore: THRESHOLD for plain firmware,
+// 0 when the controller already filters its inputs. Everything the frame
+// changes is submitted as one batch. A layer switch puts every routed target
+// of the new layer in that batch, changed or not: a target can be shared with
+// another layer, or be moved by someone else while its layer was hidden.
+// Returns true if the layer or any fader position changed.
+bool applyFrame(const Frame& frame, const RoutingTable& routing, ControllerState& state, FaderInputs& last, int threshold) {
+    bool changed = state.layer.exchange(frame.layer, std::memory_order_relaxed) != frame.layer;
+    bool switched = frame.layer != last.layer;
+    if (switched) {
+        if (last.layer >= 0) stats.layerSwitches.fetch_add(1, std::memory_order_relaxed);
+        last.layer = frame.layer;
+    }
+    auto& layer = last.layers[frame.layer];
+    last.batch.clear();
+    // fader 0 is the master
+    for (int i = 0; i <= NUM_FADERS; i++) {
+        FaderInputs::Applied& applied = i == 0 ? last.master : layer[i-1];
+        bool resend = switched && i > 0;
+        if (frame.mask & (1 << i)) {
+            int raw = i == 0 ? frame.master : frame.channels[i-1];
+            if (applied.raw >= 0 && std::abs(raw - applied.raw) <= threshold) raw = applied.raw;
+            applied.raw = raw;
+            state.raw[i+1] = raw;
+            int pct = std::clamp((raw * 100) / ADC_FULL_SCALE, 0, 100);
+            changed |= state.percents[i+1].exchange(pct) != pct;
+        } else if (resend) {
+            // A delta frame's other values still belong to the previous
+            // layer; this layer's last positions stand in for them.
+            state.raw[i+1] = applied.raw;
+            state.percents[i+1] = applied.raw < 0 ? -1 : std::clamp((applied.raw * 100) / ADC_FULL_SCALE, 0, 100);
+            changed = true;
+        } else {
+            continue;
+        }
+        if (applied.raw < 0) continue;
+
+        // Within a layer, only an audible change becomes a command.
+        Gain gain = routing.gain(i, applied.raw);
+        if (gain == applied.gain && !resend) continue;
+        applied.gain = gain;
+        if (i == 0) {
+            last.batch.emplace_back(DEFAULT_SINK_TARGET, gain);
+        } else {
+            for (TargetId target : routing.route(frame.layer, i)) last.batch.emplace_back(target, gain);
+        }
+    }
+    volumeScheduler->submit(last.batch);
+    return changed;
+}
+
+// One open controller: its decoder, link negotiation and the config section
+// it currently drives. Owned by the main loop.
+class Controller {
+public:
+    Controller(int fd, std::string path, std::string id) : fd(fd), path(std::move(path)), id(std::move(id)) {}
+
+    ~Controller() {
+        if (routing) controllerStates[section].connected.fetch_sub(1);
+        close(fd);
+        notifyControlSocket();
+    }
+
+    int descriptor() const { return fd; }
+    const std::string& devicePath() const { return path; }
+    const std::string& deviceId() const { return id; }
+
+    // The routing of the layer it is showing, for metering. Null until a link
+    // that takes meters has delivered a frame.
+    const RoutingTable* meteredTable(int& layer) const {
+        layer = meteredLayer;
+        return meteredFor;
+    }
+
+    // Set when what meteredTable() returns changed.
+    bool takeMeterRouteChange() {
+        bool changed = meterRouteChanged;
+        meterRouteChanged = false;
+        return changed;
+    }
+
+    // Sends the levels the controller does not have yet, and all of them every
+    // METER_KEEPALIVE while any is lit. Returns true while any is lit.
+    bool sendMeters(const std::array<uint8_t, NUM_FADERS>& levels, std::chrono::steady_clock::time_point now) {
+        bool lit = std::any_of(levels.begin(), levels.end(), [](uint8_t level) { return level > 0; });
+        bool keepalive = lit && now - lastMeterKeepalive >= METER_KEEPALIVE;
+        uint8_t frame[3 + NUM_FADERS];
+        size_t len = 2;
+        uint8_t mask = 0;
+        for (int i = 0; i < NUM_FADERS; i++) {
+            if (!keepalive && levels[i] == metersSent[i]) continue;
+            mask |= 1 << i;
+            frame[len++] = levels[i];
+        }
+        if (!mask) return lit;
+        frame[0] = METER_SYNC;
+        frame[1] = mask;
+        frame[len] = crc8(frame + 1, len - 1);
+        // While the link is backed up the update is skipped; the next one
+        // catches up. A frame is only ever queued whole.
+        if (!out.empty() || !send(frame, len + 1)) return lit;
+        metersSent = levels;
+        if (keepalive) lastMeterKeepalive = now;
+        return lit;
+    }
+
+    // Writes what the device takes now and queues the rest for flush(), so a
+    // frame or command is never cut short. Past CONTROLLER_MAX_QUEUED a
+    // message is dropped whole. Returns false if it was dropped or the device
+    // is gone.
+    bool send(const void* data, size_t len) {
+        if (out.size() + len > CONTROLLER_MAX_QUEUED) return false;
+        out.append(static_cast<const char*>(data), len);
+        return flush();
+    }
+
+    // Returns false once the device is gone.
+    bool flush() {
+        size_t off = 0;
+        while (off < out.size()) {
+            ssize_t n = write(fd, out.data() + off, out.size() - off);
+            if (n > 0) { off += static_cast<size_t>(n); continue; }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && errno == EAGAIN) break;
+            return false;
+        }
+        out.erase(0, off);
+        return true;
+    }
+
+    // Flips whether the loop should report the device writable: on while
+    // output is queued. Returns true when that changed.
+    bool updateWatching() {
+        bool want = !out.empty();
+        if (want == watching) return false;
+        watching = want;
+        return true;
+    }
+    bool watchingWritable() const { return watching; }
+
+    // A by-id link showed up for a device that was opened by its tty name.
+    void rename(const std::string& newId) {
+        std::cout << "[INFO] Controller " << id << " is " << newId << std::endl;
+        id = newId;
+        // Look the section up again on the next frame.
+        if (routing) controllerStates[section].connected.fetch_sub(1);
+        routing.reset();
+    }
+
+    // Drains the device. Returns false once it is gone.
+    bool onReadable() {
+        char chunk[256];
+        while (true) {
+            ssize_t n = read(fd, chunk, sizeof(chunk));
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && errno == EAGAIN) return true;
+            if (n <= 0) return false;
+
+            auto feedStart = std::chrono::steady_clock::now();
+            routed = std::chrono::steady_clock::duration::zero();
+            decoder.feed(chunk, static_cast<size_t>(n), [this](const Frame& frame) { onFrame(frame); });
+            stats.parse.record(std::chrono::steady_clock::now() - feedStart - routed);
+            stats.parseErrors.fetch_add(decoder.errorCount() - seenErrors, std::memory_order_relaxed);
+            stats.framesCorrupt.fetch_add(decoder.corruptCount() - seenCorrupt, std::memory_order_relaxed);
+            stats.framesDropped.fetch_add(decoder.droppedCount() - seenDropped, std::memory_order_relaxed);
+            seenErrors = decoder.errorCount();
+            seenCorrupt = decoder.corruptCount();
+            seenDropped = decoder.droppedCount();
+            if (decoder.takeResyncRequest()) requestFullFrame();
+            LoopStats loop;
+            if (decoder.takeLoopStats(loop) && std::chrono::steady_clock::now() - lastStatsLog >= std::chrono::minutes(1)) {
+                std::cout << "[DEBUG] Controller " << id << " loop time (us): min " << loop.minUs << " avg " << loop.avgUs
+                          << " max " << loop.maxUs << std::endl;
+                lastStatsLog = std::chrono::steady_clock::now();
+            }
+        }
+    }
+
+private:
+    void onFrame(const Frame& frame) {
+        auto routeStart = std::chrono::steady_clock::now();
+        auto now = currentRouting();
+        if (now != routing) switchRouting(std::move(now));
+        bool changed = applyFrame(frame, routing->tables[section], controllerStates[section], lastInputs,
+                                  decoder.filteredInput() ? 0 : THRESHOLD);
+        auto spent = std::chrono::steady_clock::now() - routeStart;
+        stats.route.record(spent);
+        stats.framesReceived.fetch_add(1, std::memory_order_relaxed);
+        routed += spent;
+        if (changed) notifyControlSocket();
+        const RoutingTable* metered = decoder.takesMeters() ? &routing->tables[section] : nullptr;
+        if (metered != meteredFor || frame.layer != meteredLayer) {
+            meteredFor = metered;
+            meteredLayer = frame.layer;
+            meterRouteChanged = true;
+        }
+        if (decoder.binaryMode() && !announced) {
+            std::cout << "[INFO] Controller " << id << " switched to binary frames"
+                      << (decoder.filteredInput() ? " (filtered inputs)" : "")
+                      << (decoder.takesMeters() ? " (level meters)" : "") << std::endl;
+            announced = true;
+        }
+        // Ask for binary frames once the sketch is up (opening the port resets
+        // it). Firmware that predates the binary link ignores the request and
+        // keeps sending ASCII.
+        if (!decoder.binaryMode() && binaryRequests < 3 && decoder.frameCount() >= nextRequestAt) {
+            static const char request[] = "VMX,BIN\n";
+            if (send(request, sizeof(request) - 1)) binaryRequests++;
+            nextRequestAt = decoder.frameCount() + 100;
+        }
+        // Loop timing costs the link a frame a second, so the firmware only
+        // reports it when asked.
+        static const bool statsWanted = std::getenv("VOLMIX_FIRMWARE_STATS") != nullptr;
+        if (statsWanted && !statsRequested) {
+            static const char request[] = "VMX,STATS\n";
+            statsRequested = send(request, sizeof(request) - 1);
+        }
+    }
+
+    // First frame or a new config: find this device's section. A controller
+    // only counts as connected once it has sent a frame. If it moved to
+    // another section, its faders are replayed onto that section's targets.
+    void switchRouting(std::shared_ptr<const Routing> now) {
+        int next = now->sectionFor(id);
+        bool first = routing == nullptr;
+        routing = std::move(now);
+        if (!first && next == section) {
+            lastInputs.forgetInactiveLayers();
+            return;
+        }
+        if (!first) controllerStates[section].connected.fetch_sub(1);
+        controllerStates[next].connected.fetch_add(1);
+        std::cout << "[INFO] Controller " << id << " drives "
+                  << (next == 0 ? std::string("the default section") : "section '" + routing->names[next] + "'") << std::endl;
+        section = next;
+        lastInputs = FaderInputs();
+        // Delta frames only carry what moved; get every fader once.
+        if (!first && decoder.binaryMode()) requestFullFrame();
+        notifyControlSocket();
+    }
+
+    void requestFullFrame() {
+        static const char request[] = "VMX,FULL\n";
+        send(request, sizeof(request) - 1);
+    }
+
+    int fd;
+    std::string path;
+    std::string id;
+    std::string out; // what the device has not taken yet
+    bool watching = false; // EPOLLOUT is on
+    std::shared_ptr<const Routing> routing;
+    int section = 0;
+    FaderInputs lastInputs;
+    FrameDecoder decoder;
+
+    const RoutingTable* meteredFor = nullptr;
+    int meteredLayer = -1;
+    bool meterRouteChanged = false;
+    std::array<uint8_t, NUM_FADERS> metersSent{};
+    std::chrono::steady_clock::time_point lastMeterKeepalive{};
+
+    int binaryRequests = 0;
+    uint64_t nextRequestAt = 1;
+    bool announced = false;
+    bool statsRequested = false;
+    std::chrono::steady_clock::time_point lastStatsLog = std::chrono::steady_clock::now() - std::chrono::minutes(1);
+    std::chrono::steady_clock::duration routed = std::chrono::steady_clock::duration::zero();
+    uint64_t seenErrors = 0, seenCorrupt = 0, seenDropped = 0;
+};
+
+// Every controller is served from the main event loop. New devices are noticed
+// through inotify on /dev (and /dev/serial/by-id once udev has made it), so a
+// replugged controller is back as soon as its node exists, without polling.
+class SerialHub {
+public:
+    bool start(EventLoop& eventLoop) {
+        loop = &eventLoop;
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd < 0) return false;
+        if (!loop->add(inotifyFd, EPOLLIN, [this](uint32_t) { if (drainInotify()) rescan(); })) return false;
+        if (!retryTimer.start(*loop, [this] { rescan(); })) return false;
+        // Set up whether or not the backend has meters right now: a PipeWire
+        // backend gains them when it (re)connects.
+        meterEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (meterEventFd < 0 || !meterTimer.start(*loop, [this] { sendMeters(); })) return false;
+        loop->add(meterEventFd, EPOLLIN, [this](uint32_t) {
+            uint64_t count;
+            ssize_t ignored = read(meterEventFd, &count, sizeof(count));
+            (void)ignored;
+            metersPending = false;
+            sendMeters();
+        });
+        // From the PipeWire thread: one wakeup until the loop has looked.
+        volumeBackend->setOnMeterChange([this] {
+            if (metersPending.exchange(true)) return;
+            uint64_t one = 1;
+            ssize_t ignored = write(meterEventFd, &one, sizeof(one));
+            (void)ignored;
+        });
+        rescan();
+        return true;
+    }
+
+    // Meters every node behind the faders the controllers are showing. Also
+    // called when the graph changes, to pick up nodes that were missing, and
+    // when the backend connects or disconnects; without meters the
+    // controllers' levels drop to zero.
+    void refreshMeters() {
+        if (meterEventFd < 0) return;
+        std::vector<TargetId> targets;
+        if (volumeBackend->hasMeters()) {
+            for (auto const& [path, controller] : controllers) {
+                int layer;
+                const RoutingTable* table = controller->meteredTable(layer);
+                if (!table) continue;
+                for (int fader = 1; fader <= NUM_FADERS; fader++) {
+                    for (TargetId target : table->route(layer, fader)) targets.push_back(target);
+                }
+            }
+        }
+        std::sort(targets.begin(), targets.end());
+        targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+        volumeBackend->setMeteredTargets(targets);
+        sendMeters();
+    }
+
+    // A new config may name a device that was passed over before.
+    void configChanged() {
+        if (loop) rescan();
+    }
+
+private:
+    void onEvents(Controller* controller, uint32_t events) {
+        bool ok = true;
+        if (events & EPOLLOUT) ok = controller->flush();
+        if (ok && (events & ~EPOLLOUT)) ok = controller->onReadable();
+        if (ok) {
+            if (controller->takeMeterRouteChange()) refreshMeters();
+            watchWritable(*controller);
+            return;
+        }
+        std::cout << "[INFO] Controller " << controller->deviceId() << " disconnected" << std::endl;
+        loop->remove(controller->descriptor());
+        controllers.erase(controller->devicePath());
+        refreshMeters();
+        // It may still be there (a transient error): try again shortly.
+        retryTimer.once(std::chrono::seconds(1));
+    }
+
+    // A fader with several targets shows the loudest. Rate limited to
+    // METER_INTERVAL; lit meters are looked at again after METER_STALE even
+    // without news, so stale levels fall and keepalives go out.
+    void sendMeters() {
+        auto now = std::chrono::steady_clock::now();
+        if (now < nextMeterSend) {
+            meterTimer.at(nextMeterSend);
+            return;
+        }
+        bool lit = false;
+        for (auto const& [path, controller] : controllers) {
+            int layer;
+            const RoutingTable* table = controller->meteredTable(layer);
+            if (!table) continue;
+            std::array<uint8_t, NUM_FADERS> levels{};
+            for (int fader = 1; fader <= NUM_FADERS; fader++) {
+                for (TargetId target : table->route(layer, fader)) {
+                    levels[fader - 1] = std::max(levels[fader - 1], volumeBackend->meterLevel(target));
+                }
+            }
+            lit |= controller->sendMeters(levels, now);
+            // A device that is gone shows up as a read error.
+            watchWritable(*controller);
+        }
+        nextMeterSend = now + METER_INTERVAL;
+        if (lit) meterTimer.at(now + METER_STALE);
+    }
+
+    void watchWritable(Controller& controller) {
+        if (!controller.updateWatching()) return;
+        uint32_t events = EPOLLIN;
+        if (controller.watchingWritable()) events |= EPOLLOUT;
+        loop->modify(controller.descriptor(), events);
+    }
+
+    bool drainInotify() {
+        alignas(struct inotify_event) char buf[4096];
+        bool relevant = false;
+        ssize_t n;
+        while ((n = read(inotifyFd, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + n;) {
+                auto* ev = reinterpret_cast<struct inotify_event*>(p);
+                relevant |= !ev->len || isCandidateName(ev->name) || ev->wd != devWatch;
+                p += sizeof(struct inotify_event) + ev->len;
+            }
+        }
+        return relevant;
+    }
+
+    static bool isCandidateName(const std::string& name) {
+        if (name == "serial") return true;
+        if (!serialPorts.empty()) {
+            for (auto const& port : serialPorts) {
+                size_t slash = port.rfind('/');
+                if ((slash == std::string::npos ? port : port.substr(slash + 1)) == name) return true;
+            }
+            return false;
+        }
+        return name.compare(0, 6, "ttyUSB") == 0 || name.compare(0, 6, "ttyACM") == 0;
+    }
+
+    // (path, id) for every device that should be open. Discovered devices are
+    // named by their /dev/serial/by-id link when udev has made one, which stays
+    // the same whichever ttyUSB number the kernel hands out.
+    std::vector<std::pair<std::string, std::string>> candidates() {
+        std::map<std::string, std::string> byId; // real path -> by-id name
+        if (DIR* dir = opendir(SERIAL_BY_ID_DIR)) {
+            while (dirent* entry = readdir(dir)) {
+                if (entry->d_name[0] == '.') continue;
+                std::string link = std::string(SERIAL_BY_ID_DIR) + "/" + entry->d_name;
+                char real[PATH_MAX];
+                if (realpath(link.c_str(), real)) byId[real] = entry->d_name;
+            }
+            closedir(dir);
+        }
+
+        std::vector<std::string> paths;
+        if (!serialPorts.empty()) {
+            paths = serialPorts;
+        } else {
+            for (auto const& [real, name] : byId) paths.push_back(real);
+            if (DIR* dir = opendir("/dev")) {
+                while (dirent* entry = readdir(dir)) {
+                    if (isCandidateName(entry->d_name) && std::strcmp(entry->d_name, "serial") != 0) {
+                        paths.push_back(std::string("/dev/") + entry->d_name);
+                    }
+                }
+                closedir(dir);
+            }
+        }
+
+        std::vector<std::pair<std::string, std::string>> out;
+        for (auto const& path : paths) {
+            char real[PATH_MAX];
+            if (!realpath(path.c_str(), real)) continue;
+            if (std::any_of(out.begin(), out.end(), [&](auto const& c) { return c.first == real; })) continue;
+            auto it = byId.find(real);
+            std::string id = it != byId.end() ? it->second : path.substr(path.rfind('/') + 1);
+            if (serialPorts.empty() && !looksLikeController(real, id)) continue;
+            out.emplace_back(real, id);
+        }
+        return out;
+    }
+
+    // Opening a tty and setting it up toggles DTR, which resets whatever board
+    // is behind it, so discovered devices are only opened when a config
+    // section names them or their USB id is one the firmware runs on. A 3D
+    // printer on the next port keeps printing.
+    static bool looksLikeController(const std::string& real, const std::string& id) {
+        auto routing = currentRouting();
+        for (size_t i = 1; i < routing->matches.size(); i++) {
+            if (id.find(routing->matches[i]) != std::string::npos) return true;
+        }
+        std::string usb = usbId(real);
+        if (usb.empty()) return false;
+        std::vector<std::string> known(std::begin(CONTROLLER_USB_IDS), std::end(CONTROLLER_USB_IDS));
+        if (const char* extra = std::getenv("VOLMIX_USB_IDS")) {
+            std::istringstream list(extra);
+            for (std::string entry; std::getline(list, entry, ',');) known.push_back(entry);
+        }
+        return std::any_of(known.begin(), known.end(), [&](const std::string& k) {
+            return k == usb || (k.size() == 6 && k.compare(4, 2, ":*") == 0 && usb.compare(0, 4, k, 0, 4) == 0);
+        });
+    }
+
+    // "vendor:product" of the USB device behind /dev/<tty>, from sysfs; empty
+    // for anything that is not on USB.
+    static std::string usbId(const std::string& real) {
+        std::string tty = real.substr(real.rfind('/') + 1);
+        char dev[PATH_MAX];
+        if (!realpath(("/sys/class/tty/" + tty + "/device").c_str(), dev)) return "";
+        for (std::string dir = dev; dir.size() > 4; dir.erase(dir.rfind('/'))) {
+            std::ifstream vendor(dir + "/idVendor"), product(dir + "/idProduct");
+            std::string vid, pid;
+            if (vendor >> vid && product >> pid) return vid + ":" + pid;
+        }
+        return "";
+    }
+
+    void rescan() {
+        // Watches are (re)added every time: /dev/serial/by-id comes and goes
+        // with the first and last USB serial device.
+        devWatch = inotify_add_watch(inotifyFd, "/dev", IN_CREATE | IN_ATTRIB | IN_MOVED_TO);
+        inotify_add_watch(inotifyFd, "/dev/serial", IN_CREATE | IN_MOVED_TO);
+        inotify_add_watch(inotifyFd, SERIAL_BY_ID_DIR, IN_CREATE | IN_MOVED_TO);
+        for (auto const& port : serialPorts) {
+            size_t slash = port.rfind('/');
+            std::string dir = slash == std::string::npos ? "." : slash == 0 ? "/" : port.substr(0, slash);
+            if (dir != "/dev") inotify_add_watch(inotifyFd, dir.c_str(), IN_CREATE | IN_ATTRIB | IN_MOVED_TO);
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        std::map<std::string, OpenFailure> stillFailing;
+        auto retryAt = std::chrono::steady_clock::time_point::max();
+        for (auto const& [path, id] : candidates()) {
+            auto it = controllers.find(path);
+            if (it != controllers.end()) {
+                if (it->second->deviceId() != id) it->second->rename(id);
+                continue;
+            }
+            auto failed = failures.find(path);
+            if (failed != failures.end()) {
+                OpenFailure& f = stillFailing[path] = failed->second;
+                if (f.attempts >= MAX_OPEN_ATTEMPTS) continue;
+                if (now < f.retryAt) {
+                    retryAt = std::min(retryAt, f.retryAt);
+                    continue;
+                }
+            }
+            int fd = openDevice(path);
+            if (fd < 0) {
+                int err = errno;
+                OpenFailure& f = stillFailing[path];
+                // No permission: udev may not have set it yet, and when it
+                // does, the IN_ATTRIB event brings us back here.
+                if (err == EACCES) {
+                    if (!f.reported) std::cout << "[WARN] No permission to open " << path << ", waiting for it to change" << std::endl;
+                    f.reported = true;
+                    continue;
+                }
+                // Busy (another program has it) or not ready: back off, and
+                // give up once it is clearly not going to be ours.
+                if (err != EBUSY && err != EIO) continue;
+                f.attempts++;
+                if (f.attempts >= MAX_OPEN_ATTEMPTS) {
+                    std::cout << "[WARN] Giving up on " << path << ": " << std::strerror(err) << std::endl;
+                    continue;
+                }
+                f.retryAt = now + std::chrono::seconds(1 << (f.attempts - 1));
+                retryAt = std::min(retryAt, f.retryAt);
+                continue;
+            }
+            auto controller = std::make_unique<Controller>(fd, path, id);
+            Controller* raw = controller.get();
+            if (!loop->add(fd, EPOLLIN, [this, raw](uint32_t events) { onEvents(raw, events); })) continue;
+            std::cout << "[INFO] Controller " << id << " connected on " << path << std::endl;
+            controllers.emplace(path, std::move(controller));
+        }
+        // Devices that went away start over when they come back.
+        failures = std::move(stillFailing);
+        if (retryAt != std::chrono::steady_clock::time_point::max()) retryTimer.at(retryAt);
+    }
+
+    struct OpenFailure {
+        int attempts = 0;
+        std::chrono::steady_clock::time_point retryAt{};
+        bool reported = false;
+    };
+
+    static int openDevice(const std::string& path) {
+        int fd = open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) return -1;
+        struct termios tty;
+        if (tcgetattr(fd, &tty) < 0) {
+            close(fd);
+            errno = ENOTTY;
+            return -1;
+        }
+        cfsetispeed(&tty, BAUD_RATE);
+        cfsetospeed(&tty, BAUD_RATE);
+        tty.c_cflag |= (CLOCAL | CREAD | CS8);
+        tty.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG);
+        tty.c_iflag &= ~(IXON | IXOFF | ICRNL | INLCR | IGNCR | ISTRIP);
+        tty.c_oflag &= ~OPOST;
+        tcsetattr(fd, TCSANOW, &tty);
+        return fd;
+    }
+
+    EventLoop* loop = nullptr;
+    int inotifyFd = -1;
+    int devWatch = -1;
+    LoopTimer retryTimer;
+    int meterEventFd = -1;
+    std::atomic<bool> metersPending{false};
+    LoopTimer meterTimer;
+    std::chrono::steady_clock::time_point nextMeterSend{};
+    std::map<std::string, std::unique_ptr<Controller>> controllers; // by real path
+    std::map<std::string, OpenFailure> failures;                     // by real path, devices that would not open
+};
+
+SerialHub serialHub;
+
+// --- RECONCILIATION ---
+
+// Everything the bindings point at, for when the whole graph has to be put
+// right again.
+std::vector<TargetId> boundTargets() {
+    std::vector<TargetId> targets{DEFAULT_SINK_TARGET};
+    for (auto const& section : bindings) {
+        for (auto const& [layer, faders] : section.layers) {
+            for (auto const& [faderIdx, cfg] : faders) {
+                TargetId target;
+                if (parseTarget(cfg.lastKnownId, target)) targets.push_back(target);
+            }
+        }
+    }
+    std::sort(targets.begin(), targets.end());
+    targets.erase(std::unique(targets.begin(), targets.end()), targets.end());
+    return targets;
+}
+
+// Re-applies the current fader value to targets that drifted or (re)appeared.
+// Faders that have not reported yet are left alone. With several controllers
+// the master of one that is connected wins. Only the layer on screen counts;
+// the targets of a hidden layer are set again when it comes back.
+void reassertTargets(const std::vector<TargetId>& targets) {
+    auto routing = currentRouting();
+    size_t sections = routing->tables.size();
+    for (TargetId target : targets) {
+        if (target == DEFAULT_SINK_TARGET) {
+            int best = -1;
+            for (size_t s = 0; s < sections; s++) {
+                if (controllerStates[s].raw[1] < 0) continue;
+                if (best < 0 || (controllerStates[s].connected > 0 && controllerStates[best].connected == 0)) best = static_cast<int>(s);
+            }
+            if (best >= 0) setTargetVolume(target, routing->tables[best].gain(0, controllerStates[best].raw[1]));
+            continue;
+        }
+        for (size_t s = 0; s < sections; s++) {
+            auto& state = controllerStates[s];
+            int layer = state.layer.load(std::memory_order_relaxed);
+            for (int fader = 1; fader <= NUM_FADERS; fader++) {
+                int raw = state.raw[fader+1];
+                if (raw < 0) continue;
+                for (TargetId bound : routing->tables[s].route(layer, fader)) {
+                    if (bound == target) setTargetVolume(target, routing->tables[s].gain(fader, raw));
+                }
+            }
+        }
+    }
+}
+
+// --- CONTROL SOCKET ---
+
+// Unix stream socket for the GUI (and anything else local). Every message is
+//   [type:u8][length:u32 LE][payload]
+// Requests:
+//   SUBSCRIBE      -> STATE now and on every change, NODES_CHANGED events
+//   LIST_NODES     -> NODES: "id\tmedia.class\tname\n" per node
+//   GET_BINDINGS   -> BINDINGS: the config text
+//   SET_BINDINGS   -> OK or ERROR; payload is the complete new config text
+//   GET_STATS      -> STATS: pipeline counters and latency histograms as text
+// STATE payload: one block per config section, default section first:
+//   [layer][controller connected][master + 7 faders as int8 percent, -1 = not reported]
+enum ControlMessage : uint8_t {
+    MSG_SUBSCRIBE = 0x01,
+    MSG_LIST_NODES = 0x02,
+    MSG_GET_BINDINGS = 0x03,
+    MSG_SET_BINDINGS = 0x04,
+    MSG_GET_STATS = 0x05,
+    MSG_STATE = 0x81,
+    MSG_NODES = 0x82,
+    MSG_BINDINGS = 0x83,
+    MSG_OK = 0x84,
+    MSG_ERROR = 0x85,
+    MSG_NODES_CHANGED = 0x86,
+    MSG_STATS = 0x87,
+};
+
+const size_t CONTROL_HEADER = 5;
+const size_t CONTROL_MAX_PAYLOAD = 1 << 20;
+const size_t CONTROL_MAX_QUEUED = 4 << 20; // unsent replies before a client is dropped
+const size_t STATE_BLOCK = 10;
+
+// $XDG_RUNTIME_DIR/volmix<suffix>, or a per-user name in /tmp without one.
+std::string getRuntimePath(const std::string& suffix) {
+    const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime && *runtime) return std::string(runtime) + "/volmix" + suffix;
+    return "/tmp/volmix-" + std::to_string(getuid()) + suffix;
+}
+
+// Applies a client's new config once it is on disk. The watcher may have
+// loaded the file in the meantime, in which case there is nothing left to do.
+void applyBindingUpdate(const std::string& text) {
+    if (text == appliedConfig) return;
+    appliedConfig = text;
+    std::istringstream in(text);
+    // New bindings pick up the fader's current value straight away.
+    reassertTargets(applyBindings(in, "control socket"));
+    serialHub.configChanged();
+}
+
+class ControlServer {
+public:
+    explicit ControlServer(std::string configPath) : configPath(std::move(configPath)) {}
+
+    bool start(EventLoop& eventLoop, const std::string& path) {
+        loop = &eventLoop;
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) { errno = ENAMETOOLONG; return false; }
+        listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (listenFd < 0) return false;
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        unlink(path.c_str());
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listenFd, 8) < 0) {
+            int err = errno;
+            close(listenFd);
+            errno = err;
+            listenFd = -1;
+            return false;
+        }
+        chmod(path.c_str(), 0600);
+
+        controlEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (controlEventFd < 0) return false;
+        if (!loop->add(listenFd, EPOLLIN, [this](uint32_t) { acceptClients(); }) ||
+            !loop->add(controlEventFd, EPOLLIN, [this](uint32_t) { broadcastState(); })) {
+            return false;
+        }
+        std::cout << "[INFO] Control socket at " << path << std::endl;
+        return true;
+    }
+
+private:
+    struct Client {
+        int fd = -1;
+        uint64_t serial = 0;   // tells a reused fd apart when a worker job finishes
+        std::string in;
+        std::string out;       // what the socket has not taken yet
+        bool busy = false;     // a request is finishing on the worker; later ones wait
+        bool subscribed = false;
+        std::string sentState;
+        bool stale = false;    // a state update is due once out drains
+        bool watching = false; // EPOLLOUT is on
+    };
+
+    void acceptClients() {
+        int fd;
+        while ((fd = accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK)) >= 0) {
+            if (!loop->add(fd, EPOLLIN, [this, fd](uint32_t events) { onClient(fd, events); })) {
+                close(fd);
+                continue;
+            }
+            clients[fd].fd = fd;
+            clients[fd].serial = ++lastSerial;
+        }
+    }
+
+    void onClient(int fd, uint32_t events) {
+        auto it = clients.find(fd);
+        if (it == clients.end()) return;
+        Client& c = it->second;
+        bool ok = true;
+        if (events & ~EPOLLOUT) ok = readClient(c) && processInput(c);
+        if (ok && (events & EPOLLOUT)) {
+            ok = flush(c);
+            if (ok && c.stale && c.out.empty()) ok = sendState(c, encodeState(), false);
+        }
+        if (!ok) dropClient(fd);
+        else watchWritable(c);
+    }
+
+    void broadcastState() {
+        uint64_t count;
+        ssize_t ignored = read(controlEventFd, &count, sizeof(count));
+        (void)ignored;
+        std::string state = encodeState();
+        bool graph = nodesChanged.exchange(false);
+        for (auto it = clients.begin(); it != clients.end();) {
+            Client& c = (it++)->second;
+            if (!c.subscribed) continue;
+            if (sendState(c, state, graph)) watchWritable(c);
+            else dropClient(c.fd);
+        }
+    }
+
+    // Only a client with queued output needs to hear that it can write.
+    void watchWritable(Client& c) {
+        bool want = c.stale || !c.out.empty();
+        if (want == c.watching) return;
+        c.watching = want;
+        uint32_t events = EPOLLIN;
+        if (c.watching) events |= EPOLLOUT;
+        loop->modify(c.fd, events);
+    }
+
+    bool readClient(Client& c) {
+        char buf[4096];
+        ssize_t n;
+        while ((n = read(c.fd, buf, sizeof(buf))) > 0) c.in.append(buf, static_cast<size_t>(n));
+        return !(n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR));
+    }
+
+    // Requests are answered in order: while one is busy on the worker, the
+    // ones behind it stay in c.in.
+    bool processInput(Client& c) {
+        while (!c.busy && c.in.size() >= CONTROL_HEADER) {
+            uint8_t type = static_cast<uint8_t>(c.in[0]);
+            uint32_t len = 0;
+            std::memcpy(&len, c.in.data() + 1, sizeof(len));
+            if (len > CONTROL_MAX_PAYLOAD) return false;
+            if (c.in.size() < CONTROL_HEADER + len) break;
+            std::string payload = c.in.substr(CONTROL_HEADER, len);
+            c.in.erase(0, CONTROL_HEADER + len);
+            if (!handle(c, type, payload)) return false;
+        }
+        return true;
+    }
+
+    bool handle(Client& c, uint8_t type, const std::string& payload) {
+        switch (type) {
+        case MSG_SUBSCRIBE:
+            c.subscribed = true;
+            return sendState(c, encodeState(), false);
+        case MSG_LIST_NODES: {
+            std::string out;
+            for (const auto& node : nodeRegistry.snapshot()) {
+                out += std::to_string(node.id) + "\t" + node.mediaClass + "\t" + node.displayName + "\n";
+            }
+            return send(c, MSG_NODES, out);
+        }
+        case MSG_GET_BINDINGS: {
+            std::ifstream f_in(configPath);
+            std::stringstream text;
+            text << f_in.rdbuf();
+            return send(c, MSG_BINDINGS, text.str());
+        }
+        case MSG_SET_BINDINGS: {
+            std::string error;
+            if (!validateBindings(payload, error)) return send(c, MSG_ERROR, error);
+            // The write and its fsync happen on the worker; the config is
+            // applied and the client answered once it is on disk.
+            c.busy = true;
+            loopWorker.post([this, fd = c.fd, serial = c.serial, payload, path = configPath]() -> LoopWorker::Done {
+                std::string error;
+                if (!writeFileAtomic(path, payload)) error = "cannot write " + path + ": " + std::strerror(errno);
+                return [this, fd, serial, payload, error] { finishBindingUpdate(fd, serial, payload, error); };
+            });
+            return true;
+        }
+        case MSG_GET_STATS:
+            return send(c, MSG_STATS, formatStats());
+        default:
+            return send(c, MSG_ERROR, "unknown request");
+        }
+    }
+
+    // The client may have gone away while its config was being written; the
+    // config is applied all the same.
+    void finishBindingUpdate(int fd, uint64_t serial, const std::string& text, const std::string& error) {
+        if (error.empty()) applyBindingUpdate(text);
+        auto it = clients.find(fd);
+        if (it == clients.end() || it->second.serial != serial) return;
+        Client& c = it->second;
+        c.busy = false;
+        bool ok = (error.empty() ? send(c, MSG_OK, "") : send(c, MSG_ERROR, error)) && processInput(c);
+        if (!ok) dropClient(fd);
+        else watchWritable(c);
+    }
+
+    // Subscribers only ever need the newest state, so a client that cannot
+    // keep up simply misses intermediate ones and gets the latest once its
+    // socket drains.
+    bool sendState(Client& c, const std::string& state, bool graph) {
+        if (graph && !send(c, MSG_NODES_CHANGED, "")) return false;
+        if (state == c.sentState) { c.stale = false; return true; }
+        c.stale = !c.out.empty();
+        if (c.stale) return true;
+        c.sentState = state;
+        return send(c, MSG_STATE, state);
+    }
+
+    static std::string encodeState() {
+        size_t sections = currentRouting()->tables.size();
+        std::string out(sections * STATE_BLOCK, '\0');
+        for (size_t s = 0; s < sections; s++) {
+            auto& state = controllerStates[s];
+            char* block = &out[s * STATE_BLOCK];
+            block[0] = static_cast<char>(state.layer.load(std::memory_order_relaxed));
+            block[1] = state.connected > 0 ? 1 : 0;
+            for (int i = 0; i < 8; i++) block[2 + i] = static_cast<char>(static_cast<int8_t>(state.percents[i + 1].load()));
+        }
+        return out;
+    }
+
+    // Queues the message and sends what the socket takes now; the rest goes
+    // out on EPOLLOUT. Returns false if the client has to be dropped.
+    bool send(Client& c, uint8_t type, const std::string& payload) {
+        char header[CONTROL_HEADER];
+        header[0] = static_cast<char>(type);
+        uint32_t len = static_cast<uint32_t>(payload.size());
+        std::memcpy(&header[1], &len, sizeof(len));
+        c.out.append(header, CONTROL_HEADER);
+        c.out += payload;
+        return flush(c);
+    }
+
+    bool flush(Client& c) {
+        size_t off = 0;
+        while (off < c.out.size()) {
+            ssize_t n = ::send(c.fd, c.out.data() + off, c.out.size() - off, MSG_NOSIGNAL);
+            if (n > 0) { off += static_cast<size_t>(n); continue; }
+            if (n < 0 && errno == EINTR) continue;
+            if (n < 0 && errno == EAGAIN) break;
+            return false;
+        }
+        c.out.erase(0, off);
+        // A client that stopped reading is not worth unbounded memory.
+        return c.out.size() <= CONTROL_MAX_QUEUED;
+    }
+
+    void dropClient(int fd) {
+        loop->remove(fd);
+        close(fd);
+        clients.erase(fd);
+    }
+
+    const std::string configPath;
+    EventLoop* loop = nullptr;
+    int listenFd = -1;
+    std::map<int, Client> clients; // by fd
+    uint64_t lastSerial = 0;
+};
+
+std::unique_ptr<ControlServer> controlServer;
+
+// --- MAIN LOOP ---
+
+int main(int argc, char** argv) {
+    std::string configPath;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--bench-parse" && i + 1 < argc) return benchParse(argv[++i]);
+        else if (arg == "--port" && i + 1 < argc) serialPorts.push_back(argv[++i]);
+        else if (arg == "--config" && i + 1 < argc) configPath = argv[++i];
+        else {
+            std::cout << "usage: " << argv[0] << " [--port DEVICE]... [--config FILE] | --bench-parse CAPTURE" << std::endl;
+            return 1;
+        }
+    }
+    if (configPath.empty()) configPath = getFullConfigPath();
+
+    // SIGUSR1 is read from a signalfd by the loop, so it has to be blocked
+    // before any other thread starts and inherits the mask.
+    sigset_t statsSignal;
+    sigemptyset(&statsSignal);
+    sigaddset(&statsSignal, SIGUSR1);
+    sigprocmask(SIG_BLOCK, &statsSignal, nullptr);
+
+    EventLoop& loop = eventLoop;
+    mainEventFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (!loop.start() || mainEventFd < 0 || !loopWorker.start(loop)) {
+        std::cout << "[ERROR] Cannot start the event loop: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    initVolumeBackend();
+    initVolumeScheduler();
+    volumeBackend->setOnExternalChange(notifyExternalChange);
+    volumeBackend->setOnConnectionChange(notifyConnectionChange);
+    if (!volumeBackend->watchesRegistry()) refreshRegistryFromWpctl();
+    nodeRegistry.setOnChange(notifyRegistryChanged);
+
+    // Without registry events fall back to re-reading `wpctl status`, on the
+    // worker; the registry wakes the loop if anything changed. A lost
+    // PipeWire connection is dialled again on the same tick.
+    LoopTimer registryPoll;
+    bool refreshing = false;
+    registryPoll.start(loop, [&refreshing] {
+        if (volumeBackend->watchesRegistry() || volumeBackend->reconnect() || refreshing) return;
+        refreshing = true;
+        loopWorker.post([&refreshing]() -> LoopWorker::Done {
+            refreshRegistryFromWpctl();
+            return [&refreshing] { refreshing = false; };
+        });
+    });
+    if (!volumeBackend->watchesRegistry()) registryPoll.every(std::chrono::seconds(3));
+
+    // Graph changes, external volume changes and the connection coming and
+    // going, from the PipeWire thread.
+    loop.add(mainEventFd, EPOLLIN, [&registryPoll](uint32_t) {
+        uint64_t count;
+        ssize_t ignored = read(mainEventFd, &count, sizeof(count));
+        (void)ignored;
+        bool graphChanged = false, connection = false;
+        std::vector<TargetId> drifted;
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex);
+            std::swap(graphChanged, registryDirty);
+            std::swap(connection, connectionChanged);
+            drifted.swap(pendingReassert);
+        }
+        bool restored = false;
+        if (connection && volumeBackend->watchesRegistry()) {
+            std::cout << "[INFO] PipeWire connection restored" << std::endl;
+            registryPoll.stop();
+            restored = graphChanged = true;
+        } else if (connection) {
+            std::cout << "[WARN] PipeWire connection lost, using wpctl until it is back" << std::endl;
+            registryPoll.every(std::chrono::seconds(3));
+        }
+        if (graphChanged) {
+            auto moved = refreshDynamicIds();
+            drifted.insert(drifted.end(), moved.begin(), moved.end());
+        }
+        if (graphChanged || connection) serialHub.refreshMeters();
+        // Volume is only re-applied where it actually changed behind our back
+        // or where a bound node just showed up. After a reconnect that is
+        // everything: what was set in between went nowhere.
+        if (restored) drifted = boundTargets();
+        if (!drifted.empty()) reassertTargets(drifted);
+    });
+
+    // Watch before the first load so an edit in between is not lost. New
+    // bindings pick up the fader's current value straight away.
+    auto reloadConfig = [&configPath] {
+        reassertTargets(loadConfig(configPath));
+        serialHub.configChanged();
+    };
+    LoopTimer configPoll;
+    struct stat lastSt = {};
+    if (!startConfigWatcher(loop, configPath, reloadConfig)) {
+        std::cout << "[WARN] inotify unavailable, polling the config" << std::endl;
+        stat(configPath.c_str(), &lastSt);
+        configPoll.start(loop, [&configPath, &lastSt, reloadConfig] {
+            struct stat st;
+            if (stat(configPath.c_str(), &st) != 0) return;
+            if (st.st_mtim.tv_sec == lastSt.st_mtim.tv_sec && st.st_mtim.tv_nsec == lastSt.st_mtim.tv_nsec &&
+                st.st_size == lastSt.st_size) {
+                return;
+            }
+            lastSt = st;
+            reloadConfig();
+        });
+        configPoll.every(std::chrono::seconds(1));
+    }
+    loadConfig(configPath);
+
+    std::string socketPath = getRuntimePath(".sock");
+    controlServer = std::make_unique<ControlServer>(configPath);
+    if (!controlServer->start(loop, socketPath)) {
+        std::cout << "[WARN] Control socket unavailable at " << socketPath << ": " << std::strerror(errno) << std::endl;
+    }
+
+    // SIGUSR1 dumps the stats to the log and to the stats file.
+    std::string statsPath = getRuntimePath(".stats");
+    int signalFd = signalfd(-1, &statsSignal, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signalFd < 0 || !loop.add(signalFd, EPOLLIN, [signalFd, &statsPath](uint32_t) {
+            signalfd_siginfo info;
+            bool requested = false;
+            while (read(signalFd, &info, sizeof(info)) == sizeof(info)) requested = true;
+            if (!requested) return;
+            std::string report = formatStats();
+            std::istringstream lines(report);
+            for (std::string line; std::getline(lines, line);) std::cout << "[STATS] " << line << "\n";
+            std::cout << std::flush;
+            loopWorker.post([statsPath, report]() -> LoopWorker::Done {
+                if (writeFileAtomic(statsPath, report)) return nullptr;
+                return [statsPath] { std::cout << "[WARN] Cannot write " << statsPath << std::endl; };
+            });
+        })) {
+        std::cout << "[WARN] Stats signal unavailable: " << std::strerror(errno) << std::endl;
+    }
+
+    if (!serialHub.start(loop)) {
+        std::cout << "[ERROR] Cannot start the serial loop: " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    loop.run();
+    return 1;
+}
@@ -0,0 +1,493 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include <algorithm>
+#include <map>
+#include <thread>
+#include <chrono>
+#include <mutex>
+#include <fstream>
+#include <iomanip>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <csignal>
+#include <dirent.h>
+#include <ftw.h>
+#include <sys/wait.h>
+
+#include "volmix_frame.h"
+#include "volmix_taper.h"
+
+// End-to-end benchmark for volmix_backend. Plays a fake controller on a pty,
+// runs the backend against it with the trace volume backend, and matches every
+// volume command back to the frame that asked for it.
+//
+//   g++ -std=c++17 -O2 volmix_bench.cpp -o volmix_bench -pthread
+//   ./volmix_bench [--backend ./volmix_backend] [--seconds 5] [--rate 100] [--binary]
+//                  [--group N] [idle|sweep|slam|flap|--replay capture.log]...
+
+const int NUM_LAYERS = 3;
+const int MASTER_TARGET = 0; // the trace backend prints the default sink as 0
+
+// Fader f on layer l drives node 100 + 10*l + f in the generated config. With
+// --group N it drives a group of N nodes, member k being that id + 1000*k.
+int targetFor(int layer, int fader, int member = 0) { return 100 + 10 * layer + fader + 1000 * member; }
+
+// Q24 gain the backend sets for the default cubic taper.
+Gain gainOf(int raw) { return taperGain(Taper::Cubic, raw); }
+
+long long nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct SimFrame {
+    int layer;
+    int master;
+    int channels[NUM_FADERS];
+};
+
+// --- SCENARIOS ---
+
+// Produces frame n of a scenario; false once a replay runs out.
+using Generator = bool (*)(long n, long total, SimFrame& out);
+
+int triangle(long n, long period) {
+    long p = n % period;
+    long half = period / 2;
+    return static_cast<int>((p < half ? p : period - p) * 1023 / half);
+}
+
+// Nothing moves; every command after warm-up is overhead.
+bool genIdle(long, long, SimFrame& f) {
+    f = {0, 600, {300, 300, 300, 300, 300, 300, 300}};
+    return true;
+}
+
+// One fader, full travel up and down over the whole run.
+bool genSweep(long n, long total, SimFrame& f) {
+    f = {0, 600, {triangle(n, std::max(total, 2L)), 300, 300, 300, 300, 300, 300}};
+    return true;
+}
+
+// Master and all seven faders jump end to end on every frame.
+bool genSlam(long n, long, SimFrame& f) {
+    int v = (n & 1) ? 1023 : 0;
+    f = {0, v, {v, v, v, v, v, v, v}};
+    return true;
+}
+
+// Layer changes on every frame while the faders drift.
+bool genFlap(long n, long, SimFrame& f) {
+    f.layer = static_cast<int>(n % NUM_LAYERS);
+    f.master = triangle(n, 400);
+    for (int i = 0; i < NUM_FADERS; i++) f.channels[i] = triangle(n + 37 * i, 200);
+    return true;
+}
+
+std::vector<SimFrame> replayFrames;
+
+bool genReplay(long n, long, SimFrame& f) {
+    if (n >= static_cast<long>(replayFrames.size())) return false;
+    f = replayFrames[n];
+    return true;
+}
+
+bool loadReplay(const std::string& path) {
+    std::ifstream f_in(path, std::ios::binary);
+    if (!f_in.is_open()) return false;
+    std::string line;
+    while (std::getline(f_in, line)) {
+        size_t tag = line.find("DATA,");
+        if (tag == std::string::npos) continue;
+        std::replace(line.begin(), line.end(), ',', ' ');
+        std::istringstream fields(line.substr(tag + 5));
+        SimFrame f;
+        fields >> f.layer >> f.master;
+        for (int i = 0; i < NUM_FADERS; i++) fields >> f.channels[i];
+        if (fields && f.layer >= 0 && f.layer < NUM_LAYERS) replayFrames.push_back(f);
+    }
+    return !replayFrames.empty();
+}
+
+// --- FAKE CONTROLLER ---
+
+// Speaks the same link as main.cpp: ASCII DATA lines until the host asks for
+// binary, then full and delta frames.
+class FakeController {
+public:
+    FakeController(int fd, bool allowBinary) : fd(fd), allowBinary(allowBinary) {}
+
+    // Reads host commands; runs on its own thread.
+    void listen() {
+        char buf[256];
+        std::string line;
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) {
+            for (ssize_t i = 0; i < n; i++) {
+                if (buf[i] != '\n') { line += buf[i]; continue; }
+                if (line == "VMX,BIN" && allowBinary) {
+                    std::lock_guard<std::mutex> lock(writeMutex);
+                    writeAll("VMX,OK,BIN\n");
+                    binary = true;
+                    forceFull = true;
+                } else if (line == "VMX,FULL") {
+                    forceFull = true;
+                }
+                line.clear();
+            }
+        }
+    }
+
+    bool send(const SimFrame& f) {
+        std::lock_guard<std::mutex> lock(writeMutex);
+        if (!binary) {
+            char out[96];
+            int len = snprintf(out, sizeof(out), "DATA,%d,%d,%d,%d,%d,%d,%d,%d,%d\n", f.layer, f.master,
+                               f.channels[0], f.channels[1], f.channels[2], f.channels[3],
+                               f.channels[4], f.channels[5], f.channels[6]);
+            return writeAll(std::string(out, static_cast<size_t>(len)));
+        }
+
+        int values[NUM_FADERS + 1] = {f.master};
+        std::copy(f.channels, f.channels + NUM_FADERS, values + 1);
+        bool full = forceFull.exchange(false) || f.layer != lastLayer || ++sinceFull >= 100;
+        uint8_t mask = 0;
+        for (int i = 0; i <= NUM_FADERS; i++) {
+            if (full || values[i] != lastSent[i]) mask |= static_cast<uint8_t>(1 << i);
+        }
+        if (!mask) return true;
+
+        std::string frame = encodeFrame(seq++, f.layer, full, mask, values);
+
+        std::copy(values, values + 8, lastSent);
+        lastLayer = f.layer;
+        if (full) sinceFull = 0;
+        return writeAll(frame);
+    }
+
+    bool isBinary() const { return binary; }
+
+private:
+    bool writeAll(const std::string& data) {
+        size_t off = 0;
+        while (off < data.size()) {
+            ssize_t n = write(fd, data.data() + off, data.size() - off);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            off += static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    int fd;
+    bool allowBinary;
+    std::mutex writeMutex;
+    std::atomic<bool> binary{false};
+    std::atomic<bool> forceFull{false};
+    int lastSent[NUM_FADERS + 1] = {-1, -1, -1, -1, -1, -1, -1, -1};
+    int lastLayer = -1;
+    int sinceFull = 0;
+    uint8_t seq = 0;
+};
+
+// --- TRACE COLLECTOR ---
+
+struct Command {
+    long long ns;
+    int target;
+    Gain gain;
+};
+
+class TraceCollector {
+public:
+    explicit TraceCollector(int fd) : fd(fd) {}
+
+    void run() {
+        char buf[4096];
+        std::string line;
+        ssize_t n;
+        while ((n = read(fd, buf, sizeof(buf))) > 0) {
+            for (ssize_t i = 0; i < n; i++) {
+                if (buf[i] != '\n') { line += buf[i]; continue; }
+                Command c{};
+                if (sscanf(line.c_str(), "%lld %d %u", &c.ns, &c.target, &c.gain) == 3) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    commands.push_back(c);
+                }
+                line.clear();
+            }
+        }
+    }
+
+    std::vector<Command> snapshot() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return commands;
+    }
+
+private:
+    int fd;
+    std::mutex mutex;
+    std::vector<Command> commands;
+};
+
+// --- BACKEND PROCESS ---
+
+// Sums on-CPU time over all threads of pid, from schedstat (nanoseconds).
+long long cpuNs(pid_t pid) {
+    std::string taskDir = "/proc/" + std::to_string(pid) + "/task";
+    DIR* dir = opendir(taskDir.c_str());
+    if (!dir) return 0;
+    long long total = 0;
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] == '.') continue;
+        std::ifstream stat(taskDir + "/" + entry->d_name + "/schedstat");
+        long long ns = 0;
+        if (stat >> ns) total += ns;
+    }
+    closedir(dir);
+    return total;
+}
+
+int removeEntry(const char* path, const struct stat*, int, struct FTW*) { return remove(path); }
+
+struct Result {
+    long frames = 0;
+    double framesPerSec = 0;
+    size_t commands = 0;
+    size_t unmatched = 0;
+    std::vector<long long> latencies;
+    double cpuMs = 0;
+    double wallMs = 0;
+    bool binary = false;
+};
+
+struct Options {
+    std::string backend = "./volmix_backend";
+    double seconds = 5;
+    double rate = 100;
+    bool binary = false;
+    bool verbose = false;
+    int groupSize = 1;
+};
+
+bool runScenario(const Options& opt, Generator gen, bool paced, Result& res) {
+    char tmpl[] = "/tmp/volmix-bench.XXXXXX";
+    if (!mkdtemp(tmpl)) return false;
+    std::string dir = tmpl;
+    std::string config = dir + "/volmix.conf";
+    {
+        std::ofstream f_out(config);
+        for (int l = 0; l < NUM_LAYERS; l++) {
+            for (int f = 1; f <= NUM_FADERS; f++) {
+                if (opt.groupSize == 1) {
+                    f_out << l << " " << f << " " << targetFor(l, f) << " bench\n";
+                    continue;
+                }
+                std::string group = "l" + std::to_string(l) + "f" + std::to_string(f);
+                for (int k = 0; k < opt.groupSize; k++) f_out << "group " << group << " " << targetFor(l, f, k) << " bench\n";
+                f_out << l << " " << f << " @" << group << " bench\n";
+            }
+        }
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) return false;
+    std::string slavePath = ptsname(master);
+    // Keep the slave open in raw mode so nothing is echoed before the backend
+    // configures the port itself.
+    int slave = open(slavePath.c_str(), O_RDWR | O_NOCTTY);
+    termios tty;
+    tcgetattr(slave, &tty);
+    cfmakeraw(&tty);
+    tcsetattr(slave, TCSANOW, &tty);
+
+    int trace[2];
+    if (pipe(trace) < 0) return false;
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(master);
+        close(trace[0]);
+        setenv("VOLMIX_BACKEND", "trace", 1);
+        setenv("VOLMIX_TRACE_FD", std::to_string(trace[1]).c_str(), 1);
+        setenv("XDG_RUNTIME_DIR", dir.c_str(), 1);
+        if (!opt.verbose) {
+            int null = open("/dev/null", O_WRONLY);
+            dup2(null, STDOUT_FILENO);
+        }
+        execl(opt.backend.c_str(), opt.backend.c_str(), "--port", slavePath.c_str(), "--config", config.c_str(),
+              static_cast<char*>(nullptr));
+        _exit(127);
+    }
+    close(trace[1]);
+
+    FakeController controller(master, opt.binary);
+    TraceCollector collector(trace[0]);
+    std::thread listenerThread(&FakeController::listen, &controller);
+    std::thread collectorThread(&TraceCollector::run, &collector);
+
+    // Warm up until the backend reacts, then (with --binary) until it has
+    // switched the link over.
+    SimFrame warm{0, 100, {0, 0, 0, 0, 0, 0, 0}};
+    bool ready = false;
+    for (int i = 0; i < 300 && !ready; i++) {
+        warm.master = 100 + (i % 2) * 200;
+        controller.send(warm);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ready = !collector.snapshot().empty() && (!opt.binary || controller.isBinary());
+    }
+    if (!ready) {
+        std::cout << "[ERROR] backend did not respond" << (opt.binary ? " or switch to binary" : "") << std::endl;
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    // history[target] = (time, gain) every time the expected value changed
+    std::map<int, std::vector<std::pair<long long, Gain>>> history;
+    std::map<int, Gain> expected;
+    long total = static_cast<long>(opt.seconds * opt.rate);
+    long long start = nowNs();
+    long long cpuStart = cpuNs(pid);
+    auto next = std::chrono::steady_clock::now();
+    auto interval = std::chrono::nanoseconds(static_cast<long long>(1e9 / opt.rate));
+    long n = 0;
+    SimFrame f;
+    while (ready && gen(n, total, f)) {
+        if (paced) {
+            std::this_thread::sleep_until(next);
+            next += interval;
+        } else if (nowNs() - start >= static_cast<long long>(opt.seconds * 1e9)) {
+            break;
+        }
+        // Stamped before the write: the backend may act on the frame before
+        // write() even returns.
+        long long t = nowNs();
+        if (!controller.send(f)) break;
+        auto note = [&](int target, Gain gain) {
+            auto it = expected.find(target);
+            if (it != expected.end() && it->second == gain) return;
+            expected[target] = gain;
+            history[target].push_back({t, gain});
+        };
+        note(MASTER_TARGET, gainOf(f.master));
+        for (int i = 0; i < NUM_FADERS; i++) {
+            for (int k = 0; k < opt.groupSize; k++) note(targetFor(f.layer, i + 1, k), gainOf(f.channels[i]));
+        }
+        n++;
+        if (paced && n >= total) break;
+    }
+    long long end = nowNs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    long long cpuEnd = cpuNs(pid);
+
+    kill(pid, SIGTERM);
+    waitpid(pid, nullptr, 0);
+    collectorThread.join();
+    close(trace[0]);
+    close(slave); // the listener sees EIO once no slave is left
+    listenerThread.join();
+    close(master);
+    nftw(dir.c_str(), removeEntry, 8, FTW_DEPTH | FTW_PHYS);
+
+    res.frames = n;
+    res.wallMs = (end - start) / 1e6;
+    res.framesPerSec = end > start ? n / ((end - start) / 1e9) : 0;
+    res.cpuMs = (cpuEnd - cpuStart) / 1e6;
+    res.binary = controller.isBinary();
+    for (const Command& c : collector.snapshot()) {
+        if (c.ns < start) continue;
+        res.commands++;
+        // Latency is measured from the most recent frame that first asked for
+        // this value; coalesced values simply never show up as commands.
+        auto& h = history[c.target];
+        auto it = std::upper_bound(h.begin(), h.end(), std::make_pair(c.ns, UINT32_MAX));
+        bool matched = false;
+        while (it != h.begin()) {
+            --it;
+            if (it->second == c.gain) {
+                res.latencies.push_back(c.ns - it->first);
+                matched = true;
+                break;
+            }
+        }
+        if (!matched) res.unmatched++;
+    }
+    return ready;
+}
+
+// --- REPORT ---
+
+double percentile(std::vector<long long>& v, double p) {
+    if (v.empty()) return 0;
+    size_t idx = std::min(v.size() - 1, static_cast<size_t>(p * (v.size() - 1) + 0.5));
+    std::nth_element(v.begin(), v.begin() + static_cast<std::ptrdiff_t>(idx), v.end());
+    return v[idx] / 1e3;
+}
+
+void report(const std::string& name, Result& r) {
+    double maxUs = r.latencies.empty() ? 0 : *std::max_element(r.latencies.begin(), r.latencies.end()) / 1e3;
+    std::cout << std::left << std::setw(8) << name << std::right << std::fixed
+              << std::setw(6) << (r.binary ? "bin" : "ascii")
+              << std::setw(8) << r.frames
+              << std::setprecision(0) << std::setw(10) << r.framesPerSec
+              << std::setw(8) << r.commands
+              << std::setprecision(2) << std::setw(10) << (r.frames ? double(r.commands) / r.frames : 0.0)
+              << std::setprecision(0) << std::setw(9) << percentile(r.latencies, 0.5)
+              << std::setw(9) << percentile(r.latencies, 0.99)
+              << std::setw(9) << maxUs
+              << std::setw(7) << r.unmatched
+              << std::setprecision(1) << std::setw(9) << r.cpuMs
+              << std::setw(7) << (r.wallMs > 0 ? 100.0 * r.cpuMs / r.wallMs : 0.0) << std::endl;
+}
+
+// --- MAIN ---
+
+int main(int argc, char** argv) {
+    Options opt;
+    std::vector<std::string> scenarios;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--backend" && i + 1 < argc) opt.backend = argv[++i];
+        else if (arg == "--seconds" && i + 1 < argc) opt.seconds = std::atof(argv[++i]);
+        else if (arg == "--rate" && i + 1 < argc) opt.rate = std::atof(argv[++i]);
+        else if (arg == "--binary") opt.binary = true;
+        else if (arg == "--verbose") opt.verbose = true;
+        else if (arg == "--group" && i + 1 < argc) opt.groupSize = std::atoi(argv[++i]);
+        else if (arg == "--replay" && i + 1 < argc) {
+            if (!loadReplay(argv[++i])) {
+                std::cout << "[ERROR] No DATA lines in " << argv[i] << std::endl;
+                return 1;
+            }
+            scenarios.push_back("replay");
+        } else if (arg == "idle" || arg == "sweep" || arg == "slam" || arg == "flap") {
+            scenarios.push_back(arg);
+        } else {
+            std::cout << "usage: " << argv[0] << " [--backend PATH] [--seconds N] [--rate HZ] [--binary] [--verbose]\n"
+                      << "       [--group N] [idle|sweep|slam|flap|--replay CAPTURE]..." << std::endl;
+            return 1;
+        }
+    }
+    if (opt.seconds <= 0 || opt.rate <= 0 || opt.groupSize < 1) return 1;
+    if (scenarios.empty()) scenarios = {"idle", "sweep", "slam", "flap"};
+    signal(SIGPIPE, SIG_IGN);
+
+    std::cout << "scenario  link  frames  frames/s    cmds  cmds/frm   p50 us   p99 us   max us  unmat   cpu ms  cpu %" << std::endl;
+    int failures = 0;
+    for (const auto& name : scenarios) {
+        Generator gen = name == "idle" ? genIdle : name == "sweep" ? genSweep : name == "slam" ? genSlam
+                      : name == "flap" ? genFlap : genReplay;
+        // slam runs unpaced to find the throughput ceiling.
+        Result r;
+        if (!runScenario(opt, gen, name != "slam", r)) failures++;
+        report(name, r);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,372 @@
+// Serial link between the controller (main.cpp) and the host: frame format
+// and the byte-stream decoder. Kept apart from volmix_backend.cpp so the
+// decoder can be driven from tests (tests/frame_decoder_test.cpp).
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Channel faders on a controller; the master comes on top.
+const int NUM_FADERS = 7;
+
+// Binary link, negotiated with "VMX,BIN" (see main.cpp):
+//   full:  [0xA5][seq][0<<4 | layer][master + 7 channels, 10 bit LE packed][CRC-8]
+//   delta: [0xA5][seq][1<<4 | layer][mask][changed values, 10 bit LE packed][CRC-8]
+//   stats: [0xA5][seq][2<<4 | layer][loop min, avg, max us, uint16 LE][CRC-8]
+// 0xA5 never appears in ASCII lines, so both formats can share the stream.
+// Firmware that answers "VMX,OK,BIN,...,METER" also takes level meters the
+// other way, sent only when they change:
+//   meter: [0xA6][mask][level per set bit, 0..METER_STEPS][CRC-8 of mask and levels]
+// Mask bit i is channel i. The mask and levels stay below 0x80, so the
+// firmware can tell the sync byte from its ASCII commands and resync on it.
+const uint8_t FRAME_SYNC = 0xA5;
+const uint8_t METER_SYNC = 0xA6;
+const uint8_t FRAME_FULL = 0;
+const uint8_t FRAME_DELTA = 1;
+const uint8_t FRAME_STATS = 2;
+const size_t FRAME_HEADER_LEN = 3;
+const size_t FULL_FRAME_LEN = 14;
+const size_t STATS_FRAME_LEN = 10;
+const uint8_t ALL_FIELDS = 0xFF;
+
+struct Frame {
+    int layer;
+    int master;
+    int channels[NUM_FADERS];
+    int seq;      // -1 for ASCII frames
+    uint8_t mask; // fields carried by this frame: bit 0 master, bit i+1 channel i
+};
+
+// Firmware loop timing as reported by the controller, in microseconds.
+struct LoopStats {
+    int minUs;
+    int avgUs;
+    int maxUs;
+};
+
+// CRC-8, polynomial 0x07, init 0x00
+struct Crc8Table {
+    uint8_t entries[256];
+    constexpr Crc8Table() : entries{} {
+        for (int i = 0; i < 256; i++) {
+            uint8_t crc = static_cast<uint8_t>(i);
+            for (int b = 0; b < 8; b++) crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+            entries[i] = crc;
+        }
+    }
+};
+constexpr Crc8Table CRC8_TABLE;
+
+inline uint8_t crc8(const uint8_t* data, size_t len) {
+    uint8_t crc = 0;
+    for (size_t i = 0; i < len; i++) crc = CRC8_TABLE.entries[crc ^ data[i]];
+    return crc;
+}
+
+// Bytes in a delta frame carrying the fields set in mask.
+inline size_t deltaFrameLength(uint8_t mask) {
+    return FRAME_HEADER_LEN + 1 + (__builtin_popcount(mask) * 10 + 7) / 8 + 1;
+}
+
+// A full or delta frame as the firmware sends it, from the master and channel
+// values (master first); a full frame carries them all whatever the mask.
+inline std::string encodeFrame(uint8_t seq, int layer, bool full, uint8_t mask, const int* values) {
+    if (full) mask = ALL_FIELDS;
+    std::string frame;
+    frame.reserve(full ? FULL_FRAME_LEN : deltaFrameLength(mask));
+    frame += static_cast<char>(FRAME_SYNC);
+    frame += static_cast<char>(seq);
+    frame += static_cast<char>((full ? FRAME_FULL : FRAME_DELTA) << 4 | (layer & 0x0F));
+    if (!full) frame += static_cast<char>(mask);
+    uint32_t bits = 0;
+    int nbits = 0;
+    for (int i = 0; i <= NUM_FADERS; i++) {
+        if (!(mask & (1 << i))) continue;
+        bits |= static_cast<uint32_t>(values[i] & 0x3FF) << nbits;
+        nbits += 10;
+        while (nbits >= 8) {
+            frame += static_cast<char>(bits & 0xFF);
+            bits >>= 8;
+            nbits -= 8;
+        }
+    }
+    if (nbits > 0) frame += static_cast<char>(bits & 0xFF);
+    frame += static_cast<char>(crc8(reinterpret_cast<const uint8_t*>(frame.data()) + 1, frame.size() - 1));
+    return frame;
+}
+
+// Turns the raw byte stream into frames. Bytes may arrive in any chunking;
+// complete lines are parsed straight out of the caller's buffer and only a
+// line split across reads is copied into the fixed carry-over buffer.
+// Binary frames failing their CRC are dropped and the decoder resyncs on the
+// next sync byte; gaps in the sequence counter are counted as dropped frames.
+class FrameDecoder {
+public:
+    template <typename OnFrame>
+    void feed(const char* data, size_t len, OnFrame&& onFrame) {
+        const char* end = data + len;
+        while (data < end) {
+            if (binLen > 0 || (lineLen == 0 && !overflow && static_cast<uint8_t>(*data) == FRAME_SYNC)) {
+                data = feedBinary(data, end, onFrame);
+                continue;
+            }
+
+            const char* stop = std::find_if(data, end, [](char c) {
+                return c == '\n' || static_cast<uint8_t>(c) == FRAME_SYNC;
+            });
+            if (stop == end) {
+                append(data, end);
+                return;
+            }
+            if (*stop != '\n') {
+                // A binary frame starts in the middle of a line: drop the line.
+                errors++;
+                lineLen = 0;
+                overflow = false;
+                data = stop;
+                continue;
+            }
+
+            Frame frame;
+            bool ok;
+            if (lineLen == 0 && !overflow) {
+                ok = parseLine(data, stop, frame);
+            } else {
+                append(data, stop);
+                ok = !overflow && parseLine(line, line + lineLen, frame);
+                if (overflow) errors++;
+                lineLen = 0;
+                overflow = false;
+            }
+            if (ok) {
+                frames++;
+                onFrame(frame);
+            }
+            data = stop + 1;
+        }
+    }
+
+    bool binaryMode() const { return binary; }
+    // The firmware denoises its inputs itself (announced in the handshake).
+    bool filteredInput() const { return filtered; }
+    // The firmware draws level meters sent down the link.
+    bool takesMeters() const { return meters; }
+
+    // Set after a lost or corrupt binary frame; the caller asks the firmware
+    // for a full snapshot ("VMX,FULL") instead of waiting for the keepalive.
+    bool takeResyncRequest() {
+        bool wanted = resyncWanted;
+        resyncWanted = false;
+        return wanted;
+    }
+
+    bool takeLoopStats(LoopStats& out) {
+        if (!haveLoopStats) return false;
+        out = loopStats;
+        haveLoopStats = false;
+        return true;
+    }
+    uint64_t frameCount() const { return frames; }
+    uint64_t errorCount() const { return errors; }
+    uint64_t corruptCount() const { return corrupt; }
+    uint64_t droppedCount() const { return dropped; }
+
+private:
+    void append(const char* begin, const char* end) {
+        size_t n = end - begin;
+        if (lineLen + n > sizeof(line)) { overflow = true; return; }
+        memcpy(line + lineLen, begin, n);
+        lineLen += n;
+    }
+
+    // Bytes needed before the frame length is known, then the frame length;
+    // 0 for an unknown frame type.
+    size_t wantedLength() const {
+        if (binLen < FRAME_HEADER_LEN) return FRAME_HEADER_LEN;
+        switch (bin[2] >> 4) {
+        case FRAME_FULL:
+            return FULL_FRAME_LEN;
+        case FRAME_STATS:
+            return STATS_FRAME_LEN;
+        case FRAME_DELTA:
+            if (binLen < FRAME_HEADER_LEN + 1) return FRAME_HEADER_LEN + 1;
+            return deltaFrameLength(bin[3]);
+        default:
+            return 0;
+        }
+    }
+
+    template <typename OnFrame>
+    const char* feedBinary(const char* data, const char* end, OnFrame& onFrame) {
+        while (binLen > 0 || (data < end && static_cast<uint8_t>(*data) == FRAME_SYNC)) {
+            size_t want = wantedLength();
+            if (want == 0) {
+                corrupt++;
+                resyncWanted = true;
+                resync();
+                continue;
+            }
+            if (binLen < want) {
+                if (data == end) break;
+                size_t n = std::min(want - binLen, static_cast<size_t>(end - data));
+                memcpy(bin + binLen, data, n);
+                binLen += n;
+                data += n;
+                continue;
+            }
+
+            if (bin[want - 1] != crc8(bin + 1, want - 2)) {
+                corrupt++;
+                resyncWanted = true;
+                resync();
+                continue;
+            }
+
+            Frame frame;
+            bool isData = decodeBinary(frame);
+            binLen -= want;
+            memmove(bin, bin + want, binLen);
+            binary = true;
+            if (isData) {
+                frames++;
+                onFrame(frame);
+            }
+        }
+        return data;
+    }
+
+    // Drop the rejected sync byte and restart from the next one, if buffered.
+    void resync() {
+        const void* next = binLen > 1 ? memchr(bin + 1, FRAME_SYNC, binLen - 1) : nullptr;
+        if (!next) { binLen = 0; return; }
+        size_t offset = static_cast<const uint8_t*>(next) - bin;
+        binLen -= offset;
+        memmove(bin, bin + offset, binLen);
+    }
+
+    // Deltas are merged into the last known state so every frame handed out
+    // carries the full picture; mask tells which fields actually arrived.
+    // Returns false for frames that carry no fader data.
+    bool decodeBinary(Frame& out) {
+        uint8_t type = bin[2] >> 4;
+        bool delta = type == FRAME_DELTA;
+        trackSequence(bin[1], delta);
+        if (type == FRAME_STATS) {
+            loopStats.minUs = bin[3] | (bin[4] << 8);
+            loopStats.avgUs = bin[5] | (bin[6] << 8);
+            loopStats.maxUs = bin[7] | (bin[8] << 8);
+            haveLoopStats = true;
+            return false;
+        }
+
+        out.seq = bin[1];
+        out.layer = bin[2] & 0x0F;
+        out.mask = delta ? bin[3] : ALL_FIELDS;
+
+        uint32_t bits = 0;
+        int nbits = 0;
+        const uint8_t* p = bin + FRAME_HEADER_LEN + (delta ? 1 : 0);
+        for (int i = 0; i <= NUM_FADERS; i++) {
+            if (!(out.mask & (1 << i))) continue;
+            while (nbits < 10) {
+                bits |= static_cast<uint32_t>(*p++) << nbits;
+                nbits += 8;
+            }
+            state[i] = static_cast<int>(bits & 0x3FF);
+            bits >>= 10;
+            nbits -= 10;
+        }
+        out.master = state[0];
+        for (int i = 0; i < NUM_FADERS; i++) out.channels[i] = state[i + 1];
+        return true;
+    }
+
+    void trackSequence(int seq, bool delta) {
+        if (lastSeq >= 0) {
+            uint8_t gap = static_cast<uint8_t>(seq - lastSeq - 1);
+            dropped += gap;
+            if (gap && delta) resyncWanted = true;
+        }
+        lastSeq = seq;
+    }
+
+    // "DATA,Layer,Master,Ch0,...,Ch6" with an optional trailing '\r'. Noise in
+    // front of the tag (e.g. right after the port opens) is skipped.
+    bool parseLine(const char* begin, const char* end, Frame& out) {
+        if (end > begin && end[-1] == '\r') end--;
+        if (begin == end) return false;
+
+        // Handshake replies from the firmware.
+        static const char ack[] = "VMX,OK,";
+        const char* a = std::search(begin, end, ack, ack + sizeof(ack) - 1);
+        if (a != end) {
+            std::string mode(a + sizeof(ack) - 1, end);
+            binary = mode.rfind("BIN", 0) == 0;
+            filtered = mode.find(",FILTERED") != std::string::npos;
+            meters = binary && mode.find(",METER") != std::string::npos;
+            return false;
+        }
+
+        static const char stat[] = "STAT,";
+        const char* st = std::search(begin, end, stat, stat + sizeof(stat) - 1);
+        if (st != end) {
+            LoopStats parsed;
+            int* statFields[] = { &parsed.minUs, &parsed.avgUs, &parsed.maxUs };
+            if (!parseFields(st + sizeof(stat) - 1, end, statFields, 3)) return false;
+            loopStats = parsed;
+            haveLoopStats = true;
+            return false;
+        }
+
+        static const char tag[] = "DATA,";
+        const char* p = std::search(begin, end, tag, tag + sizeof(tag) - 1);
+        if (p == end) { errors++; return false; }
+        p += sizeof(tag) - 1;
+
+        int* fields[2 + NUM_FADERS] = { &out.layer, &out.master };
+        for (int i = 0; i < NUM_FADERS; i++) fields[2 + i] = &out.channels[i];
+        if (!parseFields(p, end, fields, 2 + NUM_FADERS)) return false;
+
+        out.seq = -1;
+        out.mask = ALL_FIELDS;
+        state[0] = out.master;
+        for (int i = 0; i < NUM_FADERS; i++) state[i + 1] = out.channels[i];
+        lastSeq = -1;
+        return true;
+    }
+
+    // At least `count` comma separated integers; extra trailing fields are ignored.
+    bool parseFields(const char* p, const char* end, int* const* fields, int count) {
+        for (int i = 0; i < count; i++) {
+            auto [next, ec] = std::from_chars(p, end, *fields[i]);
+            if (ec != std::errc() || (next != end && *next != ',') || (next == end && i != count - 1)) {
+                errors++;
+                return false;
+            }
+            p = next + 1;
+        }
+        return true;
+    }
+
+    char line[128];
+    size_t lineLen = 0;
+    bool overflow = false;
+    uint8_t bin[32];
+    size_t binLen = 0;
+    int lastSeq = -1;
+    int state[1 + NUM_FADERS] = {};
+    bool binary = false;
+    bool filtered = false;
+    bool meters = false;
+    bool resyncWanted = false;
+    LoopStats loopStats = {};
+    bool haveLoopStats = false;
+    uint64_t frames = 0;
+    uint64_t errors = 0;
+    uint64_t corrupt = 0;
+    uint64_t dropped = 0;
+};
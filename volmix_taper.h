@@ -0,0 +1,79 @@
+// Fader position to volume. Shared by volmix_backend.cpp, volmix.cpp and
+// volmix_bench.cpp, so the tools agree on what a fader position means.
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+
+constexpr int ADC_STEPS = 1024;
+constexpr int ADC_FULL_SCALE = 1014; // the pots top out a little below 1023
+constexpr double TAPER_DB_RANGE = 60.0;
+
+// cubic is the curve wpctl and pavucontrol use, so it is the default.
+enum class Taper : uint8_t { Cubic, Linear, Decibel };
+
+const char* const TAPER_NAMES[] = {"cubic", "linear", "db"};
+
+inline bool parseTaper(const std::string& name, Taper& out) {
+    for (int t = 0; t < 3; t++) {
+        if (name != TAPER_NAMES[t]) continue;
+        out = static_cast<Taper>(t);
+        return true;
+    }
+    return false;
+}
+
+// exp() for the table generators: halve the argument until the series
+// converges quickly, then square back up.
+constexpr double constexprExp(double x) {
+    int halvings = 0;
+    while (x < -0.5 || x > 0.5) { x /= 2; halvings++; }
+    double term = 1, sum = 1;
+    for (int n = 1; n < 20; n++) { term *= x / n; sum += term; }
+    while (halvings-- > 0) sum *= sum;
+    return sum;
+}
+
+constexpr double constexprCbrt(double x) {
+    if (x <= 0) return 0;
+    double y = 1;
+    for (int i = 0; i < 40; i++) y -= (y * y * y - x) / (3 * y * y);
+    return y;
+}
+
+// Linear gain, 0 to 1, for a raw ADC reading. The top few steps of travel
+// all read as full scale.
+constexpr double taperCurve(Taper taper, int raw) {
+    int pos = std::clamp(raw, 0, ADC_FULL_SCALE);
+    double x = static_cast<double>(pos) / ADC_FULL_SCALE;
+    switch (taper) {
+    case Taper::Cubic: return x * x * x;
+    case Taper::Linear: return x;
+    case Taper::Decibel:
+        // -60 dB at the bottom of the travel, 0 dB at the top, off at 0.
+        return pos == 0 ? 0 : constexprExp((x - 1.0) * TAPER_DB_RANGE / 20.0 * 2.302585092994046);
+    }
+    return 0;
+}
+
+// The backend's tables, built at compile time so the frame path does one
+// lookup per fader and no floating point. Volumes are linear gain in Q24
+// fixed point, the unit of PipeWire's channelVolumes.
+using Gain = uint32_t;
+constexpr Gain GAIN_ONE = 1u << 24;
+
+struct TaperTable {
+    Gain gain[ADC_STEPS];
+    constexpr explicit TaperTable(Taper taper) : gain{} {
+        for (int raw = 0; raw < ADC_STEPS; raw++) gain[raw] = static_cast<Gain>(taperCurve(taper, raw) * GAIN_ONE + 0.5);
+    }
+};
+
+constexpr TaperTable TAPER_TABLES[] = {TaperTable(Taper::Cubic), TaperTable(Taper::Linear), TaperTable(Taper::Decibel)};
+static_assert(TAPER_TABLES[0].gain[ADC_FULL_SCALE] == GAIN_ONE && TAPER_TABLES[2].gain[ADC_FULL_SCALE] == GAIN_ONE,
+              "tapers must reach unity at full scale");
+
+inline Gain taperGain(Taper taper, int raw) {
+    return TAPER_TABLES[static_cast<int>(taper)].gain[std::clamp(raw, 0, ADC_STEPS - 1)];
+}
@@ -1,10 +1,10 @@
-import sys, subprocess, re, os
+import sys, subprocess, re, os, socket, struct
 from pathlib import Path
 from PyQt6.QtWidgets import (QApplication, QMainWindow, QWidget, QVBoxLayout,
                              QHBoxLayout, QComboBox, QLabel, QPushButton,
                              QTableWidget, QTableWidgetItem, QHeaderView,
-                             QAbstractItemView, QFileDialog, QSpinBox)
-from PyQt6.QtCore import Qt
+                             QAbstractItemView, QFileDialog, QSpinBox, QMessageBox)
+from PyQt6.QtCore import Qt, QSocketNotifier, QTimer
 from PyQt6.QtGui import QColor, QFont
 
 # Resolve the XDG-compliant path
@@ -14,6 +14,42 @@ CONFIG_FILE = str(CONFIG_DIR / "volmix.conf")
 # Create directory if it doesn't exist
 CONFIG_DIR.mkdir(parents=True, exist_ok=True)
 
+# Backend control socket, see CONTROL SOCKET in volmix_backend.cpp
+SOCKET_PATH = (os.path.join(os.environ["XDG_RUNTIME_DIR"], "volmix.sock") if os.environ.get("XDG_RUNTIME_DIR")
+               else f"/tmp/volmix-{os.getuid()}.sock")
+MSG_SUBSCRIBE, MSG_LIST_NODES, MSG_SET_BINDINGS = 0x01, 0x02, 0x04
+MSG_STATE, MSG_NODES, MSG_OK, MSG_ERROR, MSG_NODES_CHANGED = 0x81, 0x82, 0x84, 0x85, 0x86
+NODE_SECTIONS = {"Audio/Sink": "OUT", "Audio/Duplex": "OUT", "Audio/Source": "IN"}
+
+def pack_msg(msg_type, payload=b""):
+    return struct.pack("<BI", msg_type, len(payload)) + payload
+
+def split_msgs(buf):
+    """Returns complete (type, payload) messages and the leftover bytes."""
+    msgs = []
+    while len(buf) >= 5:
+        msg_type, length = struct.unpack_from("<BI", buf)
+        if len(buf) < 5 + length: break
+        msgs.append((msg_type, buf[5:5 + length])); buf = buf[5 + length:]
+    return msgs, buf
+
+def is_int(s):
+    try: int(s); return True
+    except ValueError: return False
+
+def backend_request(msg_type, payload=b""):
+    """One request/reply round trip; raises OSError if the backend is not running."""
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as s:
+        s.settimeout(1.0)
+        s.connect(SOCKET_PATH)
+        s.sendall(pack_msg(msg_type, payload))
+        buf = b""
+        while True:
+            chunk = s.recv(65536)
+            if not chunk: raise OSError("backend closed the connection")
+            msgs, buf = split_msgs(buf + chunk)
+            if msgs: return msgs[0]
+
 BREEZE_STYLE = """
     QMainWindow { background-color: #31363b; }
     QLabel { color: #eff0f1; font-family: 'Noto Sans', sans-serif; }
@@ -46,12 +82,22 @@ class VolMixMatrix(QMainWindow):
         self.all_targets = {}
         self.visible_columns = []
         self.mappings = {}
+        self.layout = []
+        self.sections = []
+        self.live = None
+        self.live_buf = b""
+        self.live_notifier = None
 
         self.init_ui()
         self.refresh_wpctl()
         self.load_config(CONFIG_FILE)
         self.rebuild_grid()
 
+        self.live_timer = QTimer(self)
+        self.live_timer.timeout.connect(self.connect_live)
+        self.live_timer.start(2000)
+        self.connect_live()
+
     def init_ui(self):
         central = QWidget()
         self.setCentralWidget(central)
@@ -63,6 +109,8 @@ class VolMixMatrix(QMainWindow):
         self.layer_spin.setRange(0, 99)
         self.layer_spin.valueChanged.connect(self.rebuild_grid)
         toolbar.addWidget(self.layer_spin)
+        self.live_label = QLabel("<small>backend offline</small>")
+        toolbar.addWidget(self.live_label)
 
         toolbar.addSpacing(30)
         self.target_picker = QComboBox()
@@ -86,8 +134,62 @@ class VolMixMatrix(QMainWindow):
         btns.addWidget(QLabel(f"<small>Config: {CONFIG_FILE}</small>"))
         layout.addLayout(btns)
 
+    def connect_live(self):
+        """Subscribes to live fader/layer state; retried by live_timer while the backend is down."""
+        if self.live: return
+        try:
+            s = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            s.connect(SOCKET_PATH)
+            s.sendall(pack_msg(MSG_SUBSCRIBE))
+            s.setblocking(False)
+        except OSError:
+            return
+        self.live, self.live_buf = s, b""
+        self.live_notifier = QSocketNotifier(s.fileno(), QSocketNotifier.Type.Read, self)
+        self.live_notifier.activated.connect(self.read_live)
+
+    def drop_live(self):
+        self.live_notifier.setEnabled(False)
+        self.live_notifier.deleteLater()
+        self.live.close()
+        self.live, self.live_notifier = None, None
+        self.live_label.setText("<small>backend offline</small>")
+        self.table.setVerticalHeaderLabels([f"FADER {i+1}" for i in range(7)])
+
+    def read_live(self):
+        try:
+            chunk = self.live.recv(65536)
+        except BlockingIOError:
+            return
+        except OSError:
+            chunk = b""
+        if not chunk: self.drop_live(); return
+        msgs, self.live_buf = split_msgs(self.live_buf + chunk)
+        for msg_type, payload in msgs:
+            if msg_type == MSG_STATE and len(payload) >= 10:
+                layer, alive = payload[0], payload[1]
+                pcts = struct.unpack_from("8b", payload, 2)
+                self.live_label.setText(f"<small>{'LIVE' if alive else 'NO CONTROLLER'} · L{layer} · "
+                                        f"M {pcts[0] if pcts[0] >= 0 else '--'}%</small>")
+                self.table.setVerticalHeaderLabels(
+                    [f"FADER {i+1}" + (f"  {p}%" if p >= 0 else "") for i, p in enumerate(pcts[1:])])
+            elif msg_type == MSG_NODES_CHANGED:
+                self.refresh_wpctl()
+
     def refresh_wpctl(self):
         self.target_picker.clear()
+        try:
+            # The backend already tracks the graph; only shell out when it is not running.
+            msg_type, payload = backend_request(MSG_LIST_NODES)
+            if msg_type == MSG_NODES:
+                for line in payload.decode(errors="replace").splitlines():
+                    id_n, media_class, name = (line.split("\t") + ["", ""])[:3]
+                    sect = NODE_SECTIONS.get(media_class, "APP" if media_class.startswith("Stream/") else "")
+                    if sect:
+                        self.all_targets[id_n] = f"[{sect}] {name}"
+                        self.target_picker.addItem(f"[{sect}] {name}", id_n)
+                return
+        except OSError: pass
         try:
             output = subprocess.check_output("wpctl status", shell=True).decode()
             sect = ""
@@ -140,24 +242,80 @@ class VolMixMatrix(QMainWindow):
                     item.setForeground(QColor("#ffffff"))
                 self.table.setItem(row, col, item)
 
+    def binding_line(self, lay, fad, tid):
+        name = re.sub(r'\[.*?\]\s*', '', self.all_targets.get(tid, "Unk"))[:10].replace(" ", "_")
+        return f"{lay} {fad} {tid} {name}\n"
+
+    def config_text(self):
+        # Every line stays where it was read. A removed binding drops out of
+        # its place, and new ones go after the last binding still in the file.
+        lines, written, insert_at = [], set(), None
+        for entry in self.layout:
+            if isinstance(entry, str):
+                lines.append(entry); continue
+            lay, fad, tid, line = entry
+            if tid in self.mappings.get((lay, fad), []) and (lay, fad, tid) not in written:
+                lines.append(line); written.add((lay, fad, tid))
+                insert_at = len(lines)
+        added = [self.binding_line(lay, fad, tid) for (lay, fad), targets in self.mappings.items()
+                 for tid in targets if (lay, fad, tid) not in written]
+        if insert_at is None: insert_at = len(lines)
+        lines[insert_at:insert_at] = added
+        lines.extend(self.sections)
+        return "".join(lines)
+
     def save_config(self, filepath):
-        with open(filepath, "w") as f:
-            for (lay, fad), targets in self.mappings.items():
-                for tid in targets:
-                    name = re.sub(r'\[.*?\]\s*', '', self.all_targets.get(tid, "Unk"))[:10].replace(" ", "_")
-                    f.write(f"{lay} {fad} {tid} {name}\n")
+        text = self.config_text()
+        if filepath == CONFIG_FILE:
+            # The backend applies the bindings at once and writes the file itself.
+            try:
+                msg_type, payload = backend_request(MSG_SET_BINDINGS, text.encode())
+                if msg_type != MSG_OK:
+                    # Nothing was written; put the grid back to what is in force.
+                    QMessageBox.warning(self, "VolMix", f"The backend rejected the config:\n{payload.decode(errors='replace')}")
+                    self.load_config(CONFIG_FILE); self.rebuild_grid()
+                return
+            except (ConnectionRefusedError, FileNotFoundError): pass
+            except OSError as e:
+                # The backend is up but did not answer (a timeout, or it went
+                # away mid-request). It may still write the file, so writing
+                # it here as well would race it.
+                QMessageBox.warning(self, "VolMix", f"The backend did not confirm the change ({e}),\n"
+                                    "so it may not have been saved.")
+                return
+        # Write a temp file and rename it over the config so the backend never
+        # sees a half-written file.
+        tmp = f"{filepath}.tmp{os.getpid()}"
+        with open(tmp, "w") as f:
+            f.write(text)
+            f.flush(); os.fsync(f.fileno())
+        os.replace(tmp, filepath)
 
     def load_config(self, filepath):
         if not os.path.exists(filepath): return
         self.mappings = {}
+        self.layout = []
+        self.sections = []
         with open(filepath, "r") as f:
             for line in f:
                 p = line.strip().split()
-                if len(p) >= 3:
+                # The grid edits the default controller; "controller" sections
+                # for other units are kept as written.
+                line = line if line.endswith("\n") else line + "\n"
+                if self.sections or (p and p[0] == "controller"):
+                    self.sections.append(line)
+                # Bindings are "layer fader id alias", as validateBindings in
+                # volmix_backend.cpp reads them.
+                elif len(p) == 4 and is_int(p[0]) and is_int(p[1]):
                     l, fad, tid = int(p[0]), int(p[1]), p[2]
                     if (l, fad) not in self.mappings: self.mappings[(l, fad)] = []
                     if tid not in self.mappings[(l, fad)]: self.mappings[(l, fad)].append(tid)
                     if tid not in self.visible_columns: self.visible_columns.append(tid)
+                    self.layout.append((l, fad, tid, line))
+                # Everything else (comments, blank lines, "taper 3 db", groups)
+                # is kept as written.
+                else:
+                    self.layout.append(line)
 
     def export_dialog(self):
         p, _ = QFileDialog.getSaveFileName(self, "Export", "", "Conf (*.conf)")